@@ -0,0 +1,253 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "alert-engine.h"
+#include <QRegExp>
+
+AlertEngine::AlertEngine(QObject *parent) :
+    QObject(parent),
+    ruleList(),
+    modelClasses(),
+    active(0)
+{
+}
+
+AlertEngine::~AlertEngine()
+{
+    qDeleteAll(ruleList);
+}
+
+void AlertEngine::addModel(const QString& qmfClass, ObjectListModel *model)
+{
+    modelClasses.insert(model, qmfClass);
+    connect(model, SIGNAL(sampleAdded(QString,Sample)), this, SLOT(sampleAdded(QString,Sample)));
+    connect(model, SIGNAL(objectRemoved(QString)), this, SLOT(objectRemoved(QString)));
+    connect(model, SIGNAL(objectsCleared()), this, SLOT(objectsCleared()));
+}
+
+// Parse and compile a rule of the form
+//   class: expression compare number [for duration]
+bool AlertEngine::addRule(const QString& text, QString *error)
+{
+    QString rest = text.trimmed();
+    int colon = rest.indexOf(':');
+    if (colon <= 0) {
+        if (error)
+            *error = "expected 'class: expression'";
+        return false;
+    }
+    QString qmfClass = rest.left(colon).trimmed();
+    rest = rest.mid(colon + 1).trimmed();
+    ObjectListModel *classModel = model(qmfClass);
+    if (!classModel) {
+        if (error)
+            *error = QString("unknown class '%1'").arg(qmfClass);
+        return false;
+    }
+
+    // optional duration: for 30, for 30s, for 5m, for 1h
+    int duration = 0;
+    QRegExp forExp("\\s+for\\s+(\\d+)\\s*(s|m|h)?\\s*$");
+    int at = forExp.indexIn(rest);
+    if (at >= 0) {
+        duration = forExp.cap(1).toInt();
+        if (forExp.cap(2) == "m")
+            duration *= 60;
+        else if (forExp.cap(2) == "h")
+            duration *= 3600;
+        rest = rest.left(at);
+    }
+
+    // the greedy match finds the last comparison in the text
+    QRegExp compareExp("^(.*[^<>=!])\\s*(>=|<=|!=|==|>|<|=)\\s*(-?[0-9.]+)\\s*$");
+    if (!compareExp.exactMatch(rest)) {
+        if (error)
+            *error = "expected 'expression compare number'";
+        return false;
+    }
+
+    Rule *rule = new Rule;
+    rule->text = text.trimmed();
+    rule->qmfClass = qmfClass;
+    rule->duration = duration;
+
+    bool ok;
+    rule->threshold = compareExp.cap(3).toDouble(&ok);
+    QString op = compareExp.cap(2);
+    if (op == ">")
+        rule->compare = Greater;
+    else if (op == ">=")
+        rule->compare = GreaterEqual;
+    else if (op == "<")
+        rule->compare = Less;
+    else if (op == "<=")
+        rule->compare = LessEqual;
+    else if (op == "!=")
+        rule->compare = NotEqual;
+    else
+        rule->compare = Equal;
+
+    if (!ok || !rule->expression.compile(compareExp.cap(1), error)) {
+        if (!ok && error)
+            *error = "bad threshold";
+        delete rule;
+        return false;
+    }
+
+    // only sampled properties reach the rule, anything else would read as 0
+    QStringList properties = rule->expression.properties();
+    QStringList::const_iterator iter = properties.constBegin();
+    while (iter != properties.constEnd()) {
+        if (!classModel->sampled().contains(*iter)) {
+            if (error)
+                *error = QString("%1 has no sampled property '%2'").arg(qmfClass).arg(*iter);
+            delete rule;
+            return false;
+        }
+        ++iter;
+    }
+
+    ruleList.append(rule);
+    return true;
+}
+
+void AlertEngine::removeRule(int index)
+{
+    Rule *rule = ruleList.takeAt(index);
+    clearStates(rule, QString());
+    delete rule;
+}
+
+QStringList AlertEngine::rules() const
+{
+    QStringList list;
+    QList<Rule *>::const_iterator iter = ruleList.constBegin();
+    while (iter != ruleList.constEnd()) {
+        list.append((*iter)->text);
+        ++iter;
+    }
+    return list;
+}
+
+QStringList AlertEngine::classes() const
+{
+    QStringList list;
+    QList<Rule *>::const_iterator iter = ruleList.constBegin();
+    while (iter != ruleList.constEnd()) {
+        if (!list.contains((*iter)->qmfClass))
+            list.append((*iter)->qmfClass);
+        ++iter;
+    }
+    return list;
+}
+
+bool AlertEngine::test(const Rule *rule, qreal value) const
+{
+    switch (rule->compare) {
+    case Greater:       return value > rule->threshold;
+    case GreaterEqual:  return value >= rule->threshold;
+    case Less:          return value < rule->threshold;
+    case LessEqual:     return value <= rule->threshold;
+    case Equal:         return value == rule->threshold;
+    case NotEqual:      return value != rule->threshold;
+    }
+    return false;
+}
+
+// SLOT triggered when a model adds a sample for an object
+void AlertEngine::sampleAdded(const QString& name, const Sample& sample)
+{
+    ObjectListModel *model = (ObjectListModel *)sender();
+    QString qmfClass = modelClasses.value(model);
+
+    QList<Rule *>::const_iterator iter = ruleList.constBegin();
+    while (iter != ruleList.constEnd()) {
+        Rule *rule = *iter;
+        ++iter;
+        if (rule->qmfClass != qmfClass)
+            continue;
+
+        qreal value = rule->expression.evaluate(sample);
+        QHash<QString, State>::iterator iState = rule->states.find(name);
+
+        if (!test(rule, value)) {
+            if (iState != rule->states.end()) {
+                if (iState.value().firing) {
+                    --active;
+                    emit alertCleared(qmfClass, name, rule->text, value);
+                }
+                rule->states.erase(iState);
+            }
+            continue;
+        }
+
+        if (iState == rule->states.end()) {
+            iState = rule->states.insert(name, State());
+            iState.value().since = sample.clock();
+        }
+        State& state = iState.value();
+        state.value = value;
+        if (!state.firing && (sample.clock() - state.since) / 1.0e9 >= rule->duration) {
+            state.firing = true;
+            ++active;
+            emit alertRaised(qmfClass, name, rule->text, value);
+        }
+    }
+}
+
+// Drop the state for an object, or all objects if name is empty
+void AlertEngine::clearStates(Rule *rule, const QString& name)
+{
+    QHash<QString, State>::iterator iState = rule->states.begin();
+    while (iState != rule->states.end()) {
+        if (!name.isEmpty() && iState.key() != name) {
+            ++iState;
+            continue;
+        }
+        if (iState.value().firing) {
+            --active;
+            emit alertCleared(rule->qmfClass, iState.key(), rule->text, iState.value().value);
+        }
+        iState = rule->states.erase(iState);
+    }
+}
+
+// SLOT triggered when an object is no longer on the broker
+void AlertEngine::objectRemoved(const QString& name)
+{
+    QString qmfClass = modelClasses.value((ObjectListModel *)sender());
+    QList<Rule *>::const_iterator iter = ruleList.constBegin();
+    while (iter != ruleList.constEnd()) {
+        if ((*iter)->qmfClass == qmfClass)
+            clearStates(*iter, name);
+        ++iter;
+    }
+}
+
+// SLOT triggered when a model discards its objects
+void AlertEngine::objectsCleared()
+{
+    QString qmfClass = modelClasses.value((ObjectListModel *)sender());
+    QList<Rule *>::const_iterator iter = ruleList.constBegin();
+    while (iter != ruleList.constEnd()) {
+        if ((*iter)->qmfClass == qmfClass)
+            clearStates(*iter, QString());
+        ++iter;
+    }
+}
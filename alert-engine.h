@@ -0,0 +1,92 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef ALERTENGINE_H
+#define ALERTENGINE_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include <QDateTime>
+#include "object-model.h"
+#include "expression.h"
+
+// Evaluates alert rules against each new sample as it is added to a model.
+//
+// A rule looks like
+//   queue: msgDepth > 1000 for 60s
+//   queue: rate1m(msgTotalEnqueues) - rate1m(msgTotalDequeues) > 0 for 5m
+// The rule is compiled when it is added. Each rule keeps a small amount of
+// state for every object it has seen, so no sample history is rescanned.
+class AlertEngine : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AlertEngine(QObject *parent = 0);
+    ~AlertEngine();
+
+    void addModel(const QString& qmfClass, ObjectListModel *model);
+    ObjectListModel *model(const QString& qmfClass) const { return modelClasses.key(qmfClass, 0); }
+
+    bool addRule(const QString& text, QString *error = 0);
+    void removeRule(int index);
+    QStringList rules() const;
+
+    // the qmf classes that have at least one rule
+    QStringList classes() const;
+    int activeCount() const { return active; }
+
+signals:
+    void alertRaised(const QString& qmfClass, const QString& name, const QString& rule, qreal value);
+    void alertCleared(const QString& qmfClass, const QString& name, const QString& rule, qreal value);
+
+private slots:
+    void sampleAdded(const QString& name, const Sample& sample);
+    void objectRemoved(const QString& name);
+    void objectsCleared();
+
+private:
+    enum Compare { Greater, GreaterEqual, Less, LessEqual, Equal, NotEqual };
+
+    struct State {
+        State() : since(0), firing(false), value(0.0) { }
+        qint64 since;       // Sample::clock() when the condition became true
+        bool firing;
+        qreal value;
+    };
+
+    struct Rule {
+        QString text;
+        QString qmfClass;
+        Expression expression;
+        Compare compare;
+        qreal threshold;
+        int duration;       // seconds the condition must hold
+        QHash<QString, State> states;
+    };
+    QList<Rule *> ruleList;
+    QHash<ObjectListModel *, QString> modelClasses;
+    int active;
+
+    bool test(const Rule *rule, qreal value) const;
+    void clearStates(Rule *rule, const QString& name);
+};
+
+#endif // ALERTENGINE_H
@@ -0,0 +1,211 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "anomaly-detector.h"
+#include <math.h>
+
+namespace {
+
+const qreal alpha = 0.05;         // weight of a new sample in the running mean and variance
+const qreal hourAlpha = 0.2;      // weight of a new visit in an hour's mean
+const qreal zRaise = 4.0;         // standard deviations from the baseline that flag an object
+const qreal zClear = 2.0;         // and that it has to come back within
+const qreal cusumSlack = 0.5;     // deviations smaller than this don't accumulate
+const qreal cusumLimit = 8.0;     // accumulated deviation that signals a change point
+
+}
+
+AnomalyDetector::Series::Series() :
+    mean(0.0), variance(0.0), count(0), lastHour(-1), cusumHigh(0.0), cusumLow(0.0), flagged(false)
+{
+    for (int i=0; i<24; ++i) {
+        hourMean[i] = 0.0;
+        hourCount[i] = 0;
+    }
+}
+
+AnomalyDetector::AnomalyDetector(QObject *parent) :
+    QObject(parent),
+    metrics()
+{
+}
+
+AnomalyDetector::~AnomalyDetector()
+{
+    qDeleteAll(metrics);
+}
+
+int AnomalyDetector::addMetric(const QString &title, ObjectListModel *model, const QString &property, bool rate)
+{
+    Metric *metric = new Metric;
+    metric->title = title;
+    metric->model = model;
+    metric->property = property;
+    metric->rate = rate;
+    metrics.append(metric);
+
+    // several metrics can share a model. Only connect once
+    if (!flaggedCounts.contains(model)) {
+        flaggedCounts.insert(model, QHash<QString, int>());
+        connect(model, SIGNAL(sampleAdded(QString,Sample)), this, SLOT(sampleAdded(QString,Sample)));
+        connect(model, SIGNAL(objectRemoved(QString)), this, SLOT(objectRemoved(QString)));
+        connect(model, SIGNAL(objectsCleared()), this, SLOT(objectsCleared()));
+    }
+    return metrics.size() - 1;
+}
+
+// Test a value against the series' baseline, then learn from it.
+// Returns true if the value is anomalous
+bool AnomalyDetector::update(Series &series, qreal value, int hour, qreal &z)
+{
+    // an hour's mean is updated once per visit to that hour, with the
+    // overall mean at the time it was left
+    if (hour != series.lastHour) {
+        if (series.lastHour >= 0 && series.count >= warmup) {
+            int last = series.lastHour;
+            if (series.hourCount[last] == 0)
+                series.hourMean[last] = series.mean;
+            else
+                series.hourMean[last] += hourAlpha * (series.mean - series.hourMean[last]);
+            if (series.hourCount[last] < 255)
+                ++series.hourCount[last];
+        }
+        series.lastHour = hour;
+    }
+
+    bool anomalous = false;
+    z = 0.0;
+    if (series.count >= warmup) {
+        qreal baseline = series.hourCount[hour] >= seasonalWarmup ? series.hourMean[hour] : series.mean;
+        // a flat series would make any change infinitely surprising
+        qreal deviation = sqrt(series.variance);
+        qreal floor = qMax((qreal)1.0, fabs(baseline) * 0.01);
+        z = (value - baseline) / qMax(deviation, floor);
+
+        series.cusumHigh = qMax((qreal)0.0, series.cusumHigh + z - cusumSlack);
+        series.cusumLow = qMax((qreal)0.0, series.cusumLow - z - cusumSlack);
+        bool shifted = series.cusumHigh > cusumLimit || series.cusumLow > cusumLimit;
+
+        if (series.flagged)
+            anomalous = fabs(z) > zClear || shifted;
+        else
+            anomalous = fabs(z) > zRaise || shifted;
+
+        // once the mean has caught up with a shift, start looking for the next one
+        if (shifted && fabs(z) < zClear) {
+            series.cusumHigh = 0.0;
+            series.cusumLow = 0.0;
+        }
+    }
+
+    qreal diff = value - series.mean;
+    if (series.count == 0)
+        series.mean = value;
+    else {
+        qreal increment = alpha * diff;
+        series.mean += increment;
+        series.variance = (1.0 - alpha) * (series.variance + diff * increment);
+    }
+    ++series.count;
+    return anomalous;
+}
+
+// SLOT triggered when a model adds a sample for an object
+void AnomalyDetector::sampleAdded(const QString &name, const Sample &sample)
+{
+    ObjectListModel *model = (ObjectListModel *)sender();
+    int hour = sample.dateTime().time().hour();
+
+    QList<Metric *>::const_iterator iter = metrics.constBegin();
+    while (iter != metrics.constEnd()) {
+        Metric *metric = *iter;
+        ++iter;
+        if (metric->model != model)
+            continue;
+
+        qreal value;
+        if (metric->rate) {
+            // the first sample of an object has no rate
+            if (!sample.hasRate(metric->property))
+                continue;
+            value = sample.rate(metric->property).value(model->getRateWindow());
+        } else
+            value = (qreal)sample.data(metric->property);
+
+        Series &series = metric->series[name];
+        qreal z;
+        bool anomalous = update(series, value, hour, z);
+        if (anomalous != series.flagged)
+            setFlagged(metric, name, series, anomalous, z);
+    }
+}
+
+void AnomalyDetector::setFlagged(Metric *metric, const QString &name, Series &series, bool flagged, qreal z)
+{
+    series.flagged = flagged;
+
+    // an object stays highlighted while any of its metrics is flagged
+    QHash<QString, int> &counts = flaggedCounts[metric->model];
+    int &count = counts[name];
+    count += flagged ? 1 : -1;
+    if (flagged && count == 1)
+        metric->model->setFlagged(name, true);
+    else if (!flagged && count <= 0) {
+        counts.remove(name);
+        metric->model->setFlagged(name, false);
+    }
+
+    if (flagged)
+        emit anomalyRaised(name, metric->title, z);
+    else
+        emit anomalyCleared(name, metric->title);
+}
+
+// SLOT triggered when an object is gone from the broker
+void AnomalyDetector::objectRemoved(const QString &name)
+{
+    ObjectListModel *model = (ObjectListModel *)sender();
+    QList<Metric *>::const_iterator iter = metrics.constBegin();
+    while (iter != metrics.constEnd()) {
+        if ((*iter)->model == model)
+            (*iter)->series.remove(name);
+        ++iter;
+    }
+    flaggedCounts[model].remove(name);
+}
+
+// SLOT triggered when a model drops its objects or its samples
+void AnomalyDetector::objectsCleared()
+{
+    ObjectListModel *model = (ObjectListModel *)sender();
+    QList<Metric *>::const_iterator iter = metrics.constBegin();
+    while (iter != metrics.constEnd()) {
+        if ((*iter)->model == model)
+            (*iter)->series.clear();
+        ++iter;
+    }
+
+    QHash<QString, int> &counts = flaggedCounts[model];
+    QHash<QString, int>::const_iterator flagged = counts.constBegin();
+    while (flagged != counts.constEnd()) {
+        model->setFlagged(flagged.key(), false);
+        ++flagged;
+    }
+    counts.clear();
+}
@@ -0,0 +1,90 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef ANOMALYDETECTOR_H
+#define ANOMALYDETECTOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include "object-model.h"
+
+// Flags objects whose metrics stray from their usual behaviour.
+// Each object and metric keeps a small fixed state that is updated as each
+// sample arrives:
+//  - an exponentially weighted mean and variance,
+//  - a mean for each hour of the day, used as the baseline once that hour
+//    has been seen often enough, so a queue that is busy every morning
+//    isn't flagged every morning,
+//  - two sided CUSUM sums of the standardized deviations, which catch a
+//    sustained shift that is too small for the z-score alone.
+// Flagged objects are highlighted through their model.
+class AnomalyDetector : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AnomalyDetector(QObject *parent = 0);
+    ~AnomalyDetector();
+
+    // watch the property of every object in model, or its rate of change
+    int addMetric(const QString &title, ObjectListModel *model, const QString &property, bool rate);
+
+    static const int warmup = 30;           // samples before anything is flagged
+    static const int seasonalWarmup = 5;    // visits to an hour before its mean is the baseline
+
+signals:
+    void anomalyRaised(const QString &name, const QString &metric, qreal z);
+    void anomalyCleared(const QString &name, const QString &metric);
+
+private slots:
+    void sampleAdded(const QString &name, const Sample &sample);
+    void objectRemoved(const QString &name);
+    void objectsCleared();
+
+private:
+    struct Series {
+        Series();
+        qreal mean;
+        qreal variance;
+        int count;
+        qreal hourMean[24];
+        quint8 hourCount[24];
+        int lastHour;
+        qreal cusumHigh;
+        qreal cusumLow;
+        bool flagged;
+    };
+
+    struct Metric {
+        QString title;
+        ObjectListModel *model;
+        QString property;
+        bool rate;
+        QHash<QString, Series> series;
+    };
+    QList<Metric *> metrics;
+
+    // the number of flagged metrics of each object, by model
+    QHash<ObjectListModel *, QHash<QString, int> > flaggedCounts;
+
+    bool update(Series &series, qreal value, int hour, qreal &z);
+    void setFlagged(Metric *metric, const QString &name, Series &series, bool flagged, qreal z);
+};
+
+#endif // ANOMALYDETECTOR_H
@@ -0,0 +1,123 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "backlog-forecast.h"
+#include <math.h>
+
+BacklogForecast::BacklogForecast(ObjectListModel *_model, const QStringList &_properties, qreal _window, QObject *parent) :
+    QObject(parent),
+    model(_model),
+    properties(_properties),
+    window(_window)
+{
+    connect(model, SIGNAL(sampleAdded(QString,Sample)), this, SLOT(sampleAdded(QString,Sample)));
+    connect(model, SIGNAL(objectRemoved(QString)), this, SLOT(objectRemoved(QString)));
+    connect(model, SIGNAL(objectsCleared()), this, SLOT(objectsCleared()));
+}
+
+// SLOT triggered when the model adds a sample for an object
+void BacklogForecast::sampleAdded(const QString &name, const Sample &sample)
+{
+    Fits &series = fits[name];
+    if (series.isEmpty())
+        series.resize(properties.size());
+
+    for (int i=0; i<properties.size(); ++i) {
+        Fit &fit = series[i];
+        qreal y = (qreal)sample.data(properties.at(i));
+
+        if (fit.count > 0) {
+            // move the origin to the new sample, then fade the older ones
+            qreal dt = (sample.clock() - fit.clock) / 1.0e9;
+            if (dt <= 0.0)
+                continue;
+            fit.stt += dt * (dt * fit.s0 - 2.0 * fit.st);
+            fit.st -= dt * fit.s0;
+            fit.sty -= dt * fit.sy;
+
+            qreal decay = exp(-dt / window);
+            fit.s0 *= decay;
+            fit.st *= decay;
+            fit.sy *= decay;
+            fit.stt *= decay;
+            fit.sty *= decay;
+        }
+        // the new sample is at time 0 so it only adds to the counts and values
+        fit.s0 += 1.0;
+        fit.sy += y;
+        fit.last = y;
+        fit.clock = sample.clock();
+        ++fit.count;
+    }
+}
+
+bool BacklogForecast::trend(const QString &name, const QString &property, qreal &level, qreal &perSecond) const
+{
+    int index = properties.indexOf(property);
+    if (index < 0)
+        return false;
+    QHash<QString, Fits>::const_iterator found = fits.constFind(name);
+    if (found == fits.constEnd())
+        return false;
+
+    const Fit &fit = found.value().at(index);
+    if (fit.count < minSamples)
+        return false;
+    qreal denominator = fit.s0 * fit.stt - fit.st * fit.st;
+    if (denominator <= 0.0)
+        return false;
+
+    level = fit.last;
+    perSecond = (fit.s0 * fit.sty - fit.st * fit.sy) / denominator;
+    return true;
+}
+
+qreal BacklogForecast::eta(qreal level, qreal target, qreal perSecond)
+{
+    if (perSecond == 0.0)
+        return -1.0;
+    qreal seconds = (target - level) / perSecond;
+    if (seconds < 0.0 || seconds > maxForecast)
+        return -1.0;
+    return seconds;
+}
+
+QString BacklogForecast::formatDuration(qreal seconds)
+{
+    qint64 secs = (qint64)(seconds + 0.5);
+    if (secs < 60)
+        return QString("%1s").arg(secs);
+    if (secs < 3600)
+        return QString("%1m %2s").arg(secs / 60).arg(secs % 60);
+    if (secs < 24 * 3600)
+        return QString("%1h %2m").arg(secs / 3600).arg((secs % 3600) / 60);
+    return QString("%1d %2h").arg(secs / (24 * 3600)).arg((secs % (24 * 3600)) / 3600);
+}
+
+// SLOT triggered when an object is gone from the broker
+void BacklogForecast::objectRemoved(const QString &name)
+{
+    fits.remove(name);
+}
+
+// SLOT triggered when the model drops its objects or its samples
+void BacklogForecast::objectsCleared()
+{
+    fits.clear();
+}
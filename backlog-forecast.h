@@ -0,0 +1,76 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef BACKLOGFORECAST_H
+#define BACKLOGFORECAST_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+#include "object-model.h"
+
+// The recent trend of properties such as a queue's depth, from a least
+// squares line through each object's samples.
+// Older samples count for less the older they are, fading with a time
+// constant of window seconds. The sums of the fit are updated as each
+// sample arrives, so nothing but five sums is kept for a series.
+class BacklogForecast : public QObject
+{
+    Q_OBJECT
+public:
+    BacklogForecast(ObjectListModel *model, const QStringList &properties, qreal window = 120.0, QObject *parent = 0);
+
+    // the latest value of an object's property and how fast it is changing.
+    // False until the object has enough samples for a trend
+    bool trend(const QString &name, const QString &property, qreal &level, qreal &perSecond) const;
+
+    // seconds until a level reaches target at a rate of change,
+    // or a negative number if it won't within maxForecast seconds
+    static qreal eta(qreal level, qreal target, qreal perSecond);
+    // a duration as e.g. "3m 20s"
+    static QString formatDuration(qreal seconds);
+
+    static const int minSamples = 5;
+    static const int maxForecast = 7 * 24 * 3600;
+
+private slots:
+    void sampleAdded(const QString &name, const Sample &sample);
+    void objectRemoved(const QString &name);
+    void objectsCleared();
+
+private:
+    // weighted sums of the samples, with time measured in seconds back
+    // from the latest sample
+    struct Fit {
+        Fit() : s0(0.0), st(0.0), sy(0.0), stt(0.0), sty(0.0), last(0.0), clock(0), count(0) { }
+        qreal s0, st, sy, stt, sty;
+        qreal last;
+        qint64 clock;
+        int count;
+    };
+    typedef QVector<Fit> Fits;
+
+    ObjectListModel *model;
+    QStringList properties;
+    qreal window;
+    QHash<QString, Fits> fits;
+};
+
+#endif // BACKLOGFORECAST_H
@@ -19,6 +19,8 @@
 
 #include "chart.h"
 #include "ui_chart.h"
+#include "diagnostics.h"
+#include "segment-store.h"
 #include <QPainter>
 #include <math.h>
 
@@ -31,12 +33,34 @@ chart::chart(QWidget *parent) :
     ui->setupUi(this);
     rate = false;
     samplesContainer = NULL;
+    storedFrom = 0;
+    storedTo = 0;
+    viewMSecs = 0;
+    mode = compareNone;
 
     ui->graph->addAction(ui->actionShow_chart);
     ui->graph->addAction(ui->actionHide_chart);
     ui->actionSep->setSeparator(true);
     ui->graph->addAction(ui->actionSep);
     ui->graph->addAction(ui->actionContigure_chart);
+
+    // ways to compare this object with the others in the section
+    compareGroup = new QActionGroup(this);
+    QAction *action = compareGroup->addAction(tr("This object only"));
+    action->setData(compareNone);
+    action->setCheckable(true);
+    action->setChecked(true);
+    action = compareGroup->addAction(tr("Overlay related objects"));
+    action->setData(compareOverlay);
+    action->setCheckable(true);
+    action = compareGroup->addAction(tr("Small multiples of related objects"));
+    action->setData(compareSmallMultiples);
+    action->setCheckable(true);
+    QAction *sep = new QAction(this);
+    sep->setSeparator(true);
+    ui->graph->addAction(sep);
+    ui->graph->addActions(compareGroup->actions());
+    connect(compareGroup, SIGNAL(triggered(QAction*)), this, SLOT(compareTriggered(QAction*)));
 }
 
 chart::~chart()
@@ -73,14 +97,50 @@ void chart::updateChart(bool isRate, ObjectListModel* samples, const QString& na
     update();
 }
 
+// The objects drawn in the compare modes. The chart's own object is drawn
+// highlighted if it is in the list
+void chart::setCompared(const QStringList& names)
+{
+    compared = names.mid(0, maxCompared);
+    update();
+}
+
+// SLOT triggered when a compare mode is picked from the context menu
+void chart::compareTriggered(QAction *action)
+{
+    mode = (CompareMode)action->data().toInt();
+    emit compareModeChanged();
+    update();
+}
+
+// Show the duration leading up to a past wall clock time, or 0 to follow now
+void chart::setViewTime(qint64 msecs)
+{
+    viewMSecs = msecs;
+    update();
+}
+
 void chart::paintEvent(QPaintEvent *e)
 {
+    Diagnostics::Timer timer("gui: chart paint");
+
     QWidget::paintEvent(e);
 
     if (properties.isEmpty())
         return;
 
-    QDateTime tnow(QDateTime::currentDateTime());
+    // the right edge of the chart
+    qint64 tnow = viewMSecs ? Sample::clockAt(viewMSecs) : Sample::now();
+
+    if (mode != compareNone && !compared.isEmpty()) {
+        QPainter painter(this);
+        painter.setRenderHint(QPainter::Antialiasing);
+        if (mode == compareOverlay)
+            paintOverlay(painter, tnow);
+        else
+            paintSmallMultiples(painter, tnow);
+        return;
+    }
 
     // get the current min and max Y vales so we can draw the y-axis
     MinMax mm;
@@ -142,14 +202,45 @@ MinMax chart::minMax(QHash<QString, pointsList>& points)
     return mm;
 }
 
-void chart::accumulate(QHash<QString, pointsList>& points, const QDateTime& tnow)
+void chart::accumulate(QHash<QString, pointsList>& points, qint64 tnow)
 {
     const ObjectListModel::Samples& samples(samplesContainer->samples());
 
     ObjectListModel::const_iterSamples iterHash = samples.constFind(oName);
-    // shallow reference to the list
-    ObjectListModel::SampleList sampleList = iterHash.value();
-    ObjectListModel::const_iterSampleList head, tail;
+    // shallow reference to the samples in the chart's window
+    ObjectListModel::SampleList sampleList;
+    if (iterHash != samples.constEnd()) {
+        const ObjectListModel::SampleList& all = iterHash.value();
+        if (viewMSecs == 0)
+            sampleList = all;
+        else {
+            // binary search for the samples between the left and right edges
+            int first = ObjectListModel::sampleIndex(all, tnow - (qint64)duration * 1000000000);
+            int last = ObjectListModel::sampleIndex(all, tnow + 1);
+            sampleList = all.mid(first, last - first);
+        }
+    }
+
+    // fill in the part of the chart older than the samples in memory from disk
+    if (samplesContainer->store()) {
+        qint64 nowMSecs = viewMSecs ? viewMSecs : QDateTime::currentMSecsSinceEpoch();
+        qint64 fromMSecs = nowMSecs - (qint64)duration * 1000;
+        qint64 toMSecs = sampleList.isEmpty() ? nowMSecs : sampleList.first().dateTime().toMSecsSinceEpoch() - 1;
+        if (toMSecs > fromMSecs) {
+            // the disk is read at most once every few seconds
+            if (oName != storedName || qAbs(fromMSecs - storedFrom) > 5000 || qAbs(toMSecs - storedTo) > 5000) {
+                storedSamples = samplesContainer->store()->read(oName, fromMSecs, toMSecs);
+                storedName = oName;
+                storedFrom = fromMSecs;
+                storedTo = toMSecs;
+            }
+            ObjectListModel::SampleList combined = storedSamples;
+            combined += sampleList;
+            sampleList = combined;
+        }
+    }
+    ObjectListModel::const_iterSampleList head;
+    SampleRate::Window window = samplesContainer->getRateWindow();
 
     points.clear();
     // for each property line
@@ -164,11 +255,8 @@ void chart::accumulate(QHash<QString, pointsList>& points, const QDateTime& tnow
             --head;
 
             if (rate) {
-                tail = head;
-                if (tail != sampleList.constBegin()) {
-                    --tail;
-                    points[prop].append(xyRate(*tail, *head, prop, tnow));
-                }
+                if ((*head).hasRate(prop))
+                    points[prop].append(xyRate(*head, prop, tnow, window));
 
             } else
                 points[prop].append(xy(*head, prop, tnow));
@@ -281,33 +369,25 @@ void chart::paintPoints(QPainter &painter, QHash<QString, pointsList>& points, M
     }
 }
 
-QPointF chart::xy(const Sample& sample, const QString& prop, const QDateTime& tnow)
+QPointF chart::xy(const Sample& sample, const QString& prop, qint64 tnow)
 {
     int width = ui->graph->width();
 
     float x, y;
-    int secs;
-    secs = sample.dateTime().secsTo(tnow);
+    double secs = sample.age(tnow);
 
-    x = width - ((float)secs / (float)duration) * width;
+    x = width - (float)(secs / duration) * width;
     y = (float)sample.data(prop);
     return QPointF(x, y);
 }
 
-QPointF chart::xyRate(const Sample& prevSample, const Sample& sample, const QString& prop, const QDateTime& tnow)
+QPointF chart::xyRate(const Sample& sample, const QString& prop, qint64 tnow, SampleRate::Window window)
 {
     int width = ui->graph->width();
 
-    float x = 0.0, y = 0.0;
-    float elapsed = prevSample.dateTime().secsTo(sample.dateTime());
-    int secs = sample.dateTime().secsTo(tnow);
-
-    qint64 value1 = sample.data(prop);
-    qint64 value2 = prevSample.data(prop);
-    if (elapsed) {
-        x = width - ((float)secs / (float)duration) * width;
-        y = (value1 - value2) / elapsed;
-    }
+    double secs = sample.age(tnow);
+    float x = width - (float)(secs / duration) * width;
+    float y = sample.rate(prop).value(window);
     return QPointF(x, y);
 }
 
@@ -425,3 +505,211 @@ QString chart::fmt_duration(int secs)
     }
     return elems;
 }
+
+// The chart's properties in a fixed order
+QStringList chart::chartProperties() const
+{
+    QStringList props = properties.keys();
+    props.sort();
+    return props;
+}
+
+// Reduce one property of an object's samples to the min and max in each
+// pixel column. The samples in the window are found with a binary search,
+// so the cost is the number of samples shown, not the number kept
+void chart::decimate(const ObjectListModel::SampleList& list, const QString& prop, qint64 tnow, int columns, Decimated& out)
+{
+    out.lo.fill(0.0, columns);
+    out.hi.fill(0.0, columns);
+    out.used.fill(false, columns);
+    out.mm = MinMax();
+    if (columns <= 0)
+        return;
+
+    qint64 span = (qint64)duration * 1000000000;
+    qint64 left = tnow - span;
+    int first = ObjectListModel::sampleIndex(list, left);
+    int last = ObjectListModel::sampleIndex(list, tnow + 1);
+    SampleRate::Window window = samplesContainer->getRateWindow();
+
+    for (int i=first; i<last; ++i) {
+        const Sample& sample = list.at(i);
+        qreal value;
+        if (rate) {
+            if (!sample.hasRate(prop))
+                continue;
+            value = sample.rate(prop).value(window);
+        } else
+            value = sample.data(prop);
+
+        int col = (int)((sample.clock() - left) * columns / span);
+        col = qBound(0, col, columns - 1);
+        if (!out.used[col]) {
+            out.used[col] = true;
+            out.lo[col] = value;
+            out.hi[col] = value;
+        } else {
+            out.lo[col] = qMin(out.lo[col], value);
+            out.hi[col] = qMax(out.hi[col], value);
+        }
+        out.mm.min = qMin(out.mm.min, value);
+        out.mm.max = qMax(out.mm.max, value);
+    }
+}
+
+// Draw a decimated series as one path, a vertical stroke in each column
+// that had samples
+void chart::drawDecimated(QPainter& painter, const Decimated& series, const QRectF& rect, const MinMax& mm)
+{
+    int columns = series.used.size();
+    if (columns == 0)
+        return;
+    qreal range = mm.max - mm.min;
+    if (range <= 0)
+        range = 1;
+    qreal colWidth = rect.width() / columns;
+
+    QPainterPath path;
+    bool moved = false;
+    for (int col=0; col<columns; ++col) {
+        if (!series.used.at(col))
+            continue;
+        qreal x = rect.left() + (col + 0.5) * colWidth;
+        qreal yHi = rect.bottom() - (series.hi.at(col) - mm.min) / range * rect.height();
+        qreal yLo = rect.bottom() - (series.lo.at(col) - mm.min) / range * rect.height();
+        if (!moved) {
+            path.moveTo(x, yHi);
+            moved = true;
+        } else
+            path.lineTo(x, yHi);
+        if (yLo != yHi)
+            path.lineTo(x, yLo);
+    }
+    painter.drawPath(path);
+}
+
+// All the compared objects' first property on one set of axes
+void chart::paintOverlay(QPainter& painter, qint64 tnow)
+{
+    QStringList props = chartProperties();
+    if (props.isEmpty())
+        return;
+    const QString& prop = props.first();
+    const ObjectListModel::Samples& samples(samplesContainer->samples());
+    int columns = ui->graph->width();
+
+    // one pass over each object's samples in the window
+    QList<Decimated> series;
+    MinMax mm;
+    QStringList::const_iterator iName = compared.constBegin();
+    while (iName != compared.constEnd()) {
+        series.append(Decimated());
+        ObjectListModel::const_iterSamples found = samples.constFind(*iName);
+        if (found != samples.constEnd())
+            decimate(found.value(), prop, tnow, columns, series.last());
+        mm.min = qMin(mm.min, series.last().mm.min);
+        mm.max = qMax(mm.max, series.last().mm.max);
+        ++iName;
+    }
+    if (mm.max < mm.min) {
+        mm.min = 0;
+        mm.max = 1;
+    }
+    mm.max = (qreal)(mm.max * 1.1 + 1.0);
+    if (mm.min > 0)
+        mm.min = 0;
+    if (mm.min < 0)
+        mm.min = (qreal)(mm.min * 1.1 - 1.0);
+
+    drawXAxis(painter, 10, 2, duration);
+    drawYAxis(painter, 6, 2, mm);
+
+    QRectF rect(0, ui->topmargin->height(), ui->graph->width(), ui->graph->height());
+    painter.setBrush(Qt::NoBrush);
+    int count = series.size();
+    int highlighted = -1;
+    for (int i=0; i<count; ++i) {
+        if (compared.at(i) == oName) {
+            // drawn last so it is on top
+            highlighted = i;
+            continue;
+        }
+        QPen pen(QColor::fromHsv(i * 360 / count, 160, 200, 160));
+        pen.setWidth(1);
+        painter.setPen(pen);
+        drawDecimated(painter, series.at(i), rect, mm);
+    }
+    if (highlighted >= 0) {
+        QPen pen(properties.value(prop));
+        pen.setWidth(2);
+        painter.setPen(pen);
+        drawDecimated(painter, series.at(highlighted), rect, mm);
+    }
+
+    QFont textFont = QFont(painter.font());
+    textFont.setPixelSize(11);
+    painter.setFont(textFont);
+    painter.setPen(QColor(88, 88, 88));
+    painter.drawText(6, ui->topmargin->height() + 12, QString("%1 (%2 objects)").arg(prop).arg(count));
+}
+
+// A grid with a sparkline of each compared object, each on its own scale
+void chart::paintSmallMultiples(QPainter& painter, qint64 tnow)
+{
+    QStringList props = chartProperties();
+    const ObjectListModel::Samples& samples(samplesContainer->samples());
+    int count = compared.size();
+
+    // cells about three times as wide as they are tall
+    int cols = qMax(1, (int)ceil(sqrt(count * (qreal)width() / (3.0 * qMax(1, height())))));
+    cols = qMin(cols, count);
+    int rows = (count + cols - 1) / cols;
+    qreal cellWidth = (qreal)width() / cols;
+    qreal cellHeight = (qreal)height() / rows;
+
+    QFont textFont = QFont(painter.font());
+    textFont.setPixelSize(9);
+    painter.setFont(textFont);
+    QFontMetrics fm(textFont);
+    int textHeight = fm.height();
+
+    Decimated series;
+    for (int i=0; i<count; ++i) {
+        const QString& name = compared.at(i);
+        QRectF cell((i % cols) * cellWidth + 1, (i / cols) * cellHeight + 1, cellWidth - 2, cellHeight - 2);
+
+        painter.setPen(name == oName ? QColor(Qt::darkGray) : QColor(220, 220, 220));
+        painter.setBrush(Qt::NoBrush);
+        painter.drawRect(cell);
+        painter.setPen(QColor(88, 88, 88));
+        painter.drawText(cell.adjusted(2, 0, -2, 0), Qt::AlignLeft | Qt::AlignTop,
+                         fm.elidedText(name, Qt::ElideMiddle, (int)cell.width() - 4));
+
+        QRectF spark = cell.adjusted(2, textHeight, -2, -2);
+        if (spark.height() < 2)
+            continue;
+        ObjectListModel::const_iterSamples found = samples.constFind(name);
+        if (found == samples.constEnd())
+            continue;
+
+        // every property of the object, each on the object's own scale
+        QList<Decimated> lines;
+        MinMax mm;
+        QStringList::const_iterator iProp = props.constBegin();
+        while (iProp != props.constEnd()) {
+            decimate(found.value(), *iProp, tnow, (int)spark.width(), series);
+            lines.append(series);
+            mm.min = qMin(mm.min, series.mm.min);
+            mm.max = qMax(mm.max, series.mm.max);
+            ++iProp;
+        }
+        if (mm.max < mm.min)
+            continue;
+        if (mm.min > 0)
+            mm.min = 0;
+        for (int p=0; p<lines.size(); ++p) {
+            painter.setPen(QPen(properties.value(props.at(p))));
+            drawDecimated(painter, lines.at(p), spark, mm);
+        }
+    }
+}
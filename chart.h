@@ -21,6 +21,7 @@
 #define CHART_H
 
 #include <QWidget>
+#include <QActionGroup>
 #include "object-model.h"
 #include <QPainterPath>
 
@@ -38,24 +39,58 @@ public:
 
     void clear();
     void updateChart(bool isRate, ObjectListModel *samples, const QString& name, const QHash<QString, QColor>& props, int duration, bool bArea);
+    void setViewTime(qint64 msecs);
+
+    // Besides the one object, the chart can compare several.
+    // Overlay draws one property of every object on the same axes, small
+    // multiples draws a sparkline of each object in a grid
+    enum CompareMode {
+        compareNone,
+        compareOverlay,
+        compareSmallMultiples
+    };
+    CompareMode compareMode() const { return mode; }
+    void setCompared(const QStringList& names);
+
+    static const int maxCompared = 100;
+
+signals:
+    // the user picked a compare mode from the chart's context menu
+    void compareModeChanged();
 
 protected:
 
     void paintEvent(QPaintEvent *event);
 
     //void plot_values(const ObjectListModel::Samples& samples, const std::string& prop, const QString& name, const QPointF& mm, int duration);
-    QPointF xy(const Sample& sample, const QString& prop, const QDateTime& tnow);
-    QPointF xyRate(const Sample& prevSample, const Sample& sample, const QString& prop, const QDateTime& tnow);
+    QPointF xy(const Sample& sample, const QString& prop, qint64 tnow);
+    QPointF xyRate(const Sample& sample, const QString& prop, qint64 tnow, SampleRate::Window window);
 
     void drawXAxis(QPainter& painter, int intervals, int step, int duration);
     void drawYAxis(QPainter& painter, int intervals, int step, const MinMax& mm);
 
     typedef QList<QPointF> pointsList;
     MinMax minMax(QHash<QString, pointsList>& points);
-    void accumulate(QHash<QString, pointsList>& points, const QDateTime& tnow);
+    void accumulate(QHash<QString, pointsList>& points, qint64 tnow);
     void paintPoints(QPainter &painter, QHash<QString, pointsList>& points, MinMax &mm);
     void paintArea(QPainter &painter, QHash<QString, pointsList>& points, MinMax &mm);
 
+    // the min and max of one series in each pixel column
+    struct Decimated {
+        QVector<qreal> lo;
+        QVector<qreal> hi;
+        QVector<bool> used;
+        MinMax mm;
+    };
+    void decimate(const ObjectListModel::SampleList& list, const QString& prop, qint64 tnow, int columns, Decimated& out);
+    void drawDecimated(QPainter& painter, const Decimated& series, const QRectF& rect, const MinMax& mm);
+    void paintOverlay(QPainter& painter, qint64 tnow);
+    void paintSmallMultiples(QPainter& painter, qint64 tnow);
+    QStringList chartProperties() const;
+
+private slots:
+    void compareTriggered(QAction *action);
+
 private:
 
     Ui::chart *ui;
@@ -70,6 +105,19 @@ private:
     int duration;
     bool rate;
     bool area;
+
+    // samples read from the model's on-disk store, and the range they cover
+    ObjectListModel::SampleList storedSamples;
+    QString storedName;
+    qint64 storedFrom;
+    qint64 storedTo;
+
+    // wall clock time at the right edge, 0 for now
+    qint64 viewMSecs;
+
+    CompareMode mode;
+    QStringList compared;
+    QActionGroup *compareGroup;
 };
 
 #endif // CHART_H
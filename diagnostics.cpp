@@ -0,0 +1,86 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "diagnostics.h"
+#include <QDateTime>
+#include <QTextStream>
+
+QMutex Diagnostics::mutex;
+QMap<QString, Histogram> Diagnostics::histograms;
+
+// started before main() so the qmf thread never races to start it
+static struct DiagnosticsClock {
+    QElapsedTimer timer;
+    DiagnosticsClock() { timer.start(); }
+} diagnosticsClock;
+
+qint64 Diagnostics::now()
+{
+    return diagnosticsClock.timer.nsecsElapsed();
+}
+
+void Diagnostics::record(const QString &name, qint64 nsecs)
+{
+    QMutexLocker locker(&mutex);
+    histograms[name].record(nsecs > 0 ? nsecs / 1000 : 0);
+}
+
+QStringList Diagnostics::names()
+{
+    QMutexLocker locker(&mutex);
+    return histograms.keys();
+}
+
+Histogram Diagnostics::histogram(const QString &name)
+{
+    QMutexLocker locker(&mutex);
+    return histograms.value(name);
+}
+
+void Diagnostics::reset()
+{
+    QMutexLocker locker(&mutex);
+    histograms.clear();
+}
+
+QString Diagnostics::report()
+{
+    QMap<QString, Histogram> copy;
+    {
+        QMutexLocker locker(&mutex);
+        copy = histograms;
+    }
+
+    QString text;
+    QTextStream out(&text);
+    out << "qpid-xview timings " << QDateTime::currentDateTime().toString(Qt::ISODate) << "\n";
+    out << "all values in microseconds\n\n";
+    out << qSetFieldWidth(32) << left << "name" << qSetFieldWidth(10) << right
+        << "count" << "mean" << "p50" << "p90" << "p99" << "max" << qSetFieldWidth(0) << "\n";
+
+    QMap<QString, Histogram>::const_iterator iter = copy.constBegin();
+    while (iter != copy.constEnd()) {
+        const Histogram &h = iter.value();
+        out << qSetFieldWidth(32) << left << iter.key() << qSetFieldWidth(10) << right
+            << h.count() << (quint64)h.mean() << h.percentile(0.5) << h.percentile(0.9)
+            << h.percentile(0.99) << h.max() << qSetFieldWidth(0) << "\n";
+        ++iter;
+    }
+    return text;
+}
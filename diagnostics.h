@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QElapsedTimer>
+#include "histogram.h"
+
+// Process wide latency recorder.
+// Each named timing keeps a histogram of microseconds. record() may be
+// called from any thread, so the qmf thread can time its queries while
+// the gui times its models and paint events.
+class Diagnostics
+{
+public:
+    static qint64 now();    // monotonic nanoseconds
+    static void record(const QString &name, qint64 nsecs);
+
+    static QStringList names();
+    static Histogram histogram(const QString &name);
+    static void reset();
+
+    // plain text table of all the timings, for attaching to bug reports
+    static QString report();
+
+    // Times the enclosing scope
+    class Timer {
+    public:
+        explicit Timer(const char *_name) : name(_name), start(Diagnostics::now()) {}
+        ~Timer() { Diagnostics::record(QLatin1String(name), Diagnostics::now() - start); }
+    private:
+        const char *name;
+        qint64 start;
+    };
+
+private:
+    static QMutex mutex;
+    static QMap<QString, Histogram> histograms;
+};
+
+#endif // DIAGNOSTICS_H
@@ -19,22 +19,18 @@
 
 #include "dialogobjects.h"
 #include "ui_dialogobjects.h"
+#include "diagnostics.h"
+#include "sparklinedelegate.h"
 
 DialogObjects::DialogObjects(QWidget *parent, const std::string& name) :
     QDialog(parent),
     objectModel(0),
-    ui(new Ui::DialogObjects)
+    objectDetailsModel(0),
+    ui(0),
+    proxyModel(0)
 {
-    ui->setupUi(this);
-    QString qname(name.c_str());
-
-    QString title("Select ");
-    title += qname;
-    ui->labelPrompt->setText(tr(title.toStdString().c_str()));
-
+    // the widgets are only created when the dialog is first shown
     this->setObjectName(QString(name.c_str()));
-
-    restoreSettings();
 }
 
 void DialogObjects::initModels(std::string unique, const QStringList &columnList)
@@ -53,27 +49,64 @@ void DialogObjects::setKey(const QString &altKey)
 
 void DialogObjects::initConnections()
 {
+    connect(objectModel, SIGNAL(objectSelected(qmf::Data)),
+            objectDetailsModel, SLOT(showObjectDetail(qmf::Data)));
+}
+
+// Create the dialog's widgets and views the first time it is needed
+void DialogObjects::ensureUi()
+{
+    if (ui)
+        return;
+    Diagnostics::Timer timer("gui: dialog setup");
+
+    ui = new Ui::DialogObjects;
+    ui->setupUi(this);
 
-    proxyModel = new QSortFilterProxyModel(this);
+    QString title("Select ");
+    title += objectName();
+    ui->labelPrompt->setText(tr(title.toStdString().c_str()));
+
+    proxyModel = new ObjectFilterProxyModel(this);
     proxyModel->setSourceModel(objectModel);
-    proxyModel->setFilterKeyColumn(0);
+    ui->objectListView->setUniformItemSizes(true);
     ui->objectListView->setModel(proxyModel);
-    connect(ui->filterLineEdit, SIGNAL(textChanged(QString)), proxyModel, SLOT(setFilterFixedString(QString)));
+
+    // chart the first sampled property next to each name. Gauges are charted
+    // as they are, the counters as rates
+    const QStringList &sampled = objectModel->sampled();
+    if (!sampled.isEmpty())
+        ui->objectListView->setItemDelegate(new SparklineDelegate(this, objectModel, sampled.first(),
+                                                                  objectModel->isCounter(sampled.first())));
+    connect(ui->filterLineEdit, SIGNAL(textChanged(QString)), proxyModel, SLOT(setFilterText(QString)));
 
     ui->objectTableView->setModel(objectDetailsModel);
 
     connect(ui->objectListView->selectionModel(), SIGNAL(currentRowChanged(QModelIndex,QModelIndex)),
             this, SLOT(selected(QModelIndex)));
-    connect(objectModel, SIGNAL(objectSelected(qmf::Data)),
-            objectDetailsModel, SLOT(showObjectDetail(qmf::Data)));
-
+    // several objects can be selected for the section's chart to compare
+    ui->objectListView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    connect(ui->objectListView->selectionModel(), SIGNAL(selectionChanged(QItemSelection,QItemSelection)),
+            this, SLOT(selectionChanged()));
     connect(objectDetailsModel, SIGNAL(detailReady()), this, SLOT(resizeDetail()));
 
+    restoreSettings();
+
+    if (objectModel->rowCount() > 0)
+        ui->objectListView->setCurrentIndex(proxyModel->index(0, 0));
+}
+
+void DialogObjects::setVisible(bool visible)
+{
+    if (visible)
+        ensureUi();
+    QDialog::setVisible(visible);
 }
 
 DialogObjects::~DialogObjects()
 {
-    saveSettings();
+    if (ui)
+        saveSettings();
     delete ui;
     if (objectModel)
         delete objectModel;
@@ -109,10 +142,29 @@ void DialogObjects::selected(const QModelIndex &index)
         objectModel->selected(filteredIndex);
     }
 }
+
+// SLOT triggered when the selection in the object list changes.
+// When more than one object is selected, they are the ones compared in the chart
+void DialogObjects::selectionChanged()
+{
+    QStringList names;
+    QModelIndexList rows = ui->objectListView->selectionModel()->selectedRows();
+    if (rows.size() > 1) {
+        QModelIndexList::const_iterator iter = rows.constBegin();
+        while (iter != rows.constEnd()) {
+            names.append(objectModel->uniqueName(proxyModel->mapToSource(*iter).row()));
+            ++iter;
+        }
+    }
+    objectModel->setCompared(names);
+}
+
 // The async request to get the data has completed
 // Add the objects to the model
 void DialogObjects::gotDataEvent(const qmf::ConsoleEvent& event, bool all)
 {
+    Diagnostics::Timer timer("gui: gotDataEvent");
+
     quint32 pcount = event.getDataCount();
     for (quint32 idx = 0; idx < pcount; idx++) {
         objectModel->addObject(event.getData(idx), event.getCorrelator());
@@ -124,7 +176,7 @@ void DialogObjects::gotDataEvent(const qmf::ConsoleEvent& event, bool all)
             objectModel->refresh(event.getCorrelator());
         }
         // select 1st item if none are selected
-        if (!(ui->objectListView->selectionModel()->hasSelection())) {
+        if (ui && !(ui->objectListView->selectionModel()->hasSelection())) {
             ui->objectListView->setCurrentIndex(ui->objectListView->model()->index(0, 0));
         }
         dataRefreshed();
@@ -134,6 +186,7 @@ void DialogObjects::gotDataEvent(const qmf::ConsoleEvent& event, bool all)
 
 void DialogObjects::setCurrentRow(const QModelIndex& row)
 {
+    ensureUi();
     // row is the index for the object-model
     // translate this into the row for the listview
     QModelIndex prow = proxyModel->mapFromSource(row);
@@ -142,6 +195,15 @@ void DialogObjects::setCurrentRow(const QModelIndex& row)
 
 void DialogObjects::dataRefreshed()
 {
+    if (!ui) {
+        // the dialog was never shown so there are no details to update,
+        // but the section still refreshes its own object
+        if (objectModel->rowCount() > 0)
+            emit objectRefreshed();
+        objectModel->expireSamples();
+        return;
+    }
+
     QModelIndex current = ui->objectListView->selectionModel()->currentIndex();
 
     if (current.isValid()) {
@@ -156,6 +218,7 @@ void DialogObjects::dataRefreshed()
 }
 void DialogObjects::accept()
 {
+    ensureUi();
     // get the currently selected object in the list
     QModelIndex index = ui->objectListView->selectionModel()->currentIndex();
     if (index.isValid()) {
@@ -22,8 +22,8 @@
 
 #include <QDialog>
 #include <QSettings>
-#include <QSortFilterProxyModel>
 #include "object-model.h"
+#include "filter-model.h"
 #include "object-details.h"
 #include <qmf/ConsoleEvent.h>
 
@@ -44,6 +44,8 @@ public:
     ObjectListModel *listModel() { return objectModel; }
 
     void gotDataEvent(const qmf::ConsoleEvent& event, bool all);
+    void setVisible(bool visible);
+
 public slots:
     void connectionChanged(bool isConnected);
     void accept();
@@ -65,13 +67,15 @@ signals:
     void finalAdded();
 
 private:
-    Ui::DialogObjects *ui;
+    Ui::DialogObjects *ui;  // created on first show
+    void ensureUi();
     void saveSettings();
     void restoreSettings();
-    QSortFilterProxyModel *proxyModel;
+    ObjectFilterProxyModel *proxyModel;
 
 private slots:
     void resizeDetail();
+    void selectionChanged();
 };
 
 #endif // DialogObjects_H
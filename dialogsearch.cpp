@@ -0,0 +1,169 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "dialogsearch.h"
+#include "ui_dialogsearch.h"
+#include <QApplication>
+#include <QSettings>
+#include <QKeyEvent>
+#include <QElapsedTimer>
+
+static const int maxResults = 100;
+
+DialogSearch::DialogSearch(QWidget *parent, SearchIndex *index) :
+    QDialog(parent),
+    ui(new Ui::DialogSearch),
+    searchIndex(index),
+    debounce(this)
+{
+    ui->setupUi(this);
+    setObjectName("search");
+
+    debounce.setSingleShot(true);
+    debounce.setInterval(100);
+    connect(&debounce, SIGNAL(timeout()), this, SLOT(runSearch()));
+
+    connect(ui->searchLineEdit, SIGNAL(textChanged(QString)), this, SLOT(textChanged()));
+    connect(ui->searchLineEdit, SIGNAL(returnPressed()), this, SLOT(accept()));
+    connect(ui->resultListWidget, SIGNAL(itemActivated(QListWidgetItem*)),
+            this, SLOT(activated(QListWidgetItem*)));
+
+    // let the arrow keys move through the results while typing
+    ui->searchLineEdit->installEventFilter(this);
+
+    restoreSettings();
+}
+
+DialogSearch::~DialogSearch()
+{
+    saveSettings();
+    delete ui;
+}
+
+// SLOT triggered by the find menu item / shortcut
+void DialogSearch::popup()
+{
+    ui->searchLineEdit->selectAll();
+    show();
+    raise();
+    activateWindow();
+    ui->searchLineEdit->setFocus();
+    runSearch();
+}
+
+void DialogSearch::textChanged()
+{
+    debounce.start();
+}
+
+void DialogSearch::runSearch()
+{
+    debounce.stop();
+    ui->resultListWidget->clear();
+
+    QString query = ui->searchLineEdit->text().trimmed();
+    if (query.isEmpty()) {
+        ui->labelStatus->setText(QString("%1 objects").arg(searchIndex->size()));
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    SearchIndex::ResultList results = searchIndex->search(query, maxResults, &error);
+    qint64 elapsed = timer.elapsed();
+    if (!error.isEmpty()) {
+        ui->labelStatus->setText(error);
+        return;
+    }
+
+    SearchIndex::ResultList::const_iterator iter = results.constBegin();
+    while (iter != results.constEnd()) {
+        QListWidgetItem *item = new QListWidgetItem(QString("%1   (%2)").arg((*iter).label).arg((*iter).qmfClass));
+        item->setData(Qt::UserRole, (*iter).qmfClass);
+        item->setData(Qt::UserRole + 1, (*iter).name);
+        ui->resultListWidget->addItem(item);
+        ++iter;
+    }
+    if (ui->resultListWidget->count() > 0)
+        ui->resultListWidget->setCurrentRow(0);
+
+    ui->labelStatus->setText(QString("%1 matches in %2 ms").arg(results.size()).arg(elapsed));
+}
+
+bool DialogSearch::eventFilter(QObject *object, QEvent *event)
+{
+    if (object == ui->searchLineEdit && event->type() == QEvent::KeyPress) {
+        QKeyEvent *keyEvent = (QKeyEvent *)event;
+        int key = keyEvent->key();
+        if (key == Qt::Key_Up || key == Qt::Key_Down ||
+            key == Qt::Key_PageUp || key == Qt::Key_PageDown) {
+            QApplication::sendEvent(ui->resultListWidget, event);
+            return true;
+        }
+    }
+    return QDialog::eventFilter(object, event);
+}
+
+void DialogSearch::accept()
+{
+    // pick up any typing that hasn't been searched yet
+    if (debounce.isActive())
+        runSearch();
+
+    QListWidgetItem *item = ui->resultListWidget->currentItem();
+    if (item)
+        activated(item);
+    else
+        close();
+}
+
+// SLOT triggered when a result is double clicked or return is pressed
+void DialogSearch::activated(QListWidgetItem *item)
+{
+    QString qmfClass = item->data(Qt::UserRole).toString();
+    QString name = item->data(Qt::UserRole + 1).toString();
+
+    ObjectListModel *model = searchIndex->model(qmfClass);
+    if (model) {
+        int row = model->findRow(name);
+        if (row >= 0) {
+            close();
+            emit setCurrentObject(model->qmfData(row), qmfClass);
+            return;
+        }
+    }
+    ui->labelStatus->setText(QString("%1 is no longer available").arg(name));
+}
+
+void DialogSearch::saveSettings() {
+    QSettings settings;
+
+    settings.beginGroup(objectName());
+    settings.setValue("Geometry", saveGeometry());
+    settings.endGroup();
+}
+
+void DialogSearch::restoreSettings() {
+    QSettings settings;
+
+    settings.beginGroup(objectName());
+    restoreGeometry(settings.value("Geometry").toByteArray());
+    settings.endGroup();
+}
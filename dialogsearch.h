@@ -0,0 +1,68 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef DIALOGSEARCH_H
+#define DIALOGSEARCH_H
+
+#include <QDialog>
+#include <QTimer>
+#include <QModelIndex>
+#include "search-index.h"
+
+namespace Ui {
+    class DialogSearch;
+}
+
+class QListWidgetItem;
+
+// A search palette over the objects of all the sections
+class DialogSearch : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DialogSearch(QWidget *parent, SearchIndex *index);
+    ~DialogSearch();
+
+public slots:
+    void popup();
+    void accept();
+
+signals:
+    // user picked an object
+    void setCurrentObject(const qmf::Data&, const QString &);
+
+protected:
+    bool eventFilter(QObject *object, QEvent *event);
+
+private slots:
+    void textChanged();
+    void runSearch();
+    void activated(QListWidgetItem *item);
+
+private:
+    Ui::DialogSearch *ui;
+    SearchIndex *searchIndex;
+    QTimer debounce;
+
+    void saveSettings();
+    void restoreSettings();
+};
+
+#endif // DIALOGSEARCH_H
@@ -0,0 +1,147 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "dockalerts.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QDateTime>
+
+DockAlerts::DockAlerts(QWidget *parent, AlertEngine *engine) :
+    QDockWidget(tr("Alerts"), parent),
+    alertEngine(engine)
+{
+    setObjectName("Alerts");
+
+    QWidget *contents = new QWidget(this);
+    QVBoxLayout *layout = new QVBoxLayout(contents);
+    layout->setContentsMargins(2, 2, 2, 2);
+
+    tableAlerts = new QTableWidget(0, 4, contents);
+    tableAlerts->setHorizontalHeaderLabels(QStringList() << tr("since") << tr("object") << tr("value") << tr("rule"));
+    tableAlerts->verticalHeader()->hide();
+    tableAlerts->horizontalHeader()->setStretchLastSection(true);
+    tableAlerts->setSelectionBehavior(QAbstractItemView::SelectRows);
+    tableAlerts->setSelectionMode(QAbstractItemView::SingleSelection);
+    tableAlerts->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    layout->addWidget(tableAlerts, 2);
+
+    listRules = new QListWidget(contents);
+    layout->addWidget(listRules, 1);
+
+    QHBoxLayout *ruleLayout = new QHBoxLayout();
+    lineEditRule = new QLineEdit(contents);
+    lineEditRule->setToolTip(tr("class: expression compare number [for duration]\n"
+                                "e.g. queue: msgDepth > 1000 for 60s"));
+    buttonAdd = new QPushButton(tr("Add"), contents);
+    buttonRemove = new QPushButton(tr("Remove"), contents);
+    ruleLayout->addWidget(lineEditRule);
+    ruleLayout->addWidget(buttonAdd);
+    ruleLayout->addWidget(buttonRemove);
+    layout->addLayout(ruleLayout);
+    setWidget(contents);
+
+    fillRules();
+
+    connect(alertEngine, SIGNAL(alertRaised(QString,QString,QString,qreal)),
+            this, SLOT(alertRaised(QString,QString,QString,qreal)));
+    connect(alertEngine, SIGNAL(alertCleared(QString,QString,QString,qreal)),
+            this, SLOT(alertCleared(QString,QString,QString,qreal)));
+    connect(lineEditRule, SIGNAL(returnPressed()), this, SLOT(addRule()));
+    connect(buttonAdd, SIGNAL(clicked()), this, SLOT(addRule()));
+    connect(buttonRemove, SIGNAL(clicked()), this, SLOT(removeRule()));
+    connect(tableAlerts, SIGNAL(itemDoubleClicked(QTableWidgetItem*)), this, SLOT(activated(QTableWidgetItem*)));
+}
+
+void DockAlerts::fillRules()
+{
+    listRules->clear();
+    listRules->addItems(alertEngine->rules());
+}
+
+// SLOT triggered when a rule starts firing for an object
+void DockAlerts::alertRaised(const QString& qmfClass, const QString& name, const QString& rule, qreal value)
+{
+    int row = tableAlerts->rowCount();
+    tableAlerts->insertRow(row);
+
+    QTableWidgetItem *item = new QTableWidgetItem(QDateTime::currentDateTime().toString("hh:mm:ss"));
+    item->setData(Qt::UserRole, qmfClass);
+    tableAlerts->setItem(row, 0, item);
+    tableAlerts->setItem(row, 1, new QTableWidgetItem(name));
+    item = new QTableWidgetItem(QString::number(value, 'g', 6));
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    tableAlerts->setItem(row, 2, item);
+    tableAlerts->setItem(row, 3, new QTableWidgetItem(rule));
+}
+
+// SLOT triggered when a rule stops firing for an object
+void DockAlerts::alertCleared(const QString& qmfClass, const QString& name, const QString& rule, qreal value)
+{
+    Q_UNUSED(value);
+    for (int row=0; row<tableAlerts->rowCount(); ++row) {
+        if (tableAlerts->item(row, 1)->text() == name &&
+            tableAlerts->item(row, 3)->text() == rule &&
+            tableAlerts->item(row, 0)->data(Qt::UserRole).toString() == qmfClass) {
+            tableAlerts->removeRow(row);
+            return;
+        }
+    }
+}
+
+void DockAlerts::addRule()
+{
+    QString text = lineEditRule->text().trimmed();
+    if (text.isEmpty())
+        return;
+
+    QString error;
+    if (!alertEngine->addRule(text, &error)) {
+        emit ruleError(tr("Bad alert rule: %1").arg(error));
+        return;
+    }
+    lineEditRule->clear();
+    fillRules();
+    emit rulesChanged();
+}
+
+void DockAlerts::removeRule()
+{
+    int row = listRules->currentRow();
+    if (row < 0)
+        return;
+
+    alertEngine->removeRule(row);
+    fillRules();
+    emit rulesChanged();
+}
+
+// SLOT triggered when an alert is double clicked
+void DockAlerts::activated(QTableWidgetItem *item)
+{
+    QString qmfClass = tableAlerts->item(item->row(), 0)->data(Qt::UserRole).toString();
+    QString name = tableAlerts->item(item->row(), 1)->text();
+
+    ObjectListModel *model = alertEngine->model(qmfClass);
+    if (!model)
+        return;
+    int row = model->findRow(name);
+    if (row >= 0)
+        emit setCurrentObject(model->qmfData(row), qmfClass);
+}
@@ -0,0 +1,63 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef DOCKALERTS_H
+#define DOCKALERTS_H
+
+#include <QDockWidget>
+#include <QTableWidget>
+#include <QListWidget>
+#include <QLineEdit>
+#include <QPushButton>
+#include "alert-engine.h"
+
+// A dock panel that lists the alerts that are currently raised
+// and lets the user add and remove alert rules
+class DockAlerts : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit DockAlerts(QWidget *parent, AlertEngine *engine);
+
+signals:
+    // user picked an object
+    void setCurrentObject(const qmf::Data&, const QString &);
+    void rulesChanged();
+    void ruleError(const QString& message);
+
+private slots:
+    void alertRaised(const QString& qmfClass, const QString& name, const QString& rule, qreal value);
+    void alertCleared(const QString& qmfClass, const QString& name, const QString& rule, qreal value);
+    void addRule();
+    void removeRule();
+    void activated(QTableWidgetItem *item);
+
+private:
+    AlertEngine *alertEngine;
+    QTableWidget *tableAlerts;
+    QListWidget *listRules;
+    QLineEdit *lineEditRule;
+    QPushButton *buttonAdd;
+    QPushButton *buttonRemove;
+
+    void fillRules();
+};
+
+#endif // DOCKALERTS_H
@@ -0,0 +1,156 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "dockdiagnostics.h"
+#include "diagnostics.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QFile>
+#include <QTextStream>
+
+DockDiagnostics::DockDiagnostics(QWidget *parent) :
+    QDockWidget(tr("Diagnostics"), parent),
+    lagTimer(),
+    refreshTimer(),
+    lastProbe(0)
+{
+    setObjectName("Diagnostics");
+
+    QWidget *contents = new QWidget(this);
+    QVBoxLayout *layout = new QVBoxLayout(contents);
+    layout->setContentsMargins(2, 2, 2, 2);
+
+    tableWidget = new QTableWidget(0, 5, contents);
+    tableWidget->setHorizontalHeaderLabels(QStringList() << tr("timing") << tr("count")
+                                           << tr("p50 ms") << tr("p99 ms") << tr("max ms"));
+    tableWidget->verticalHeader()->hide();
+    tableWidget->horizontalHeader()->setResizeMode(0, QHeaderView::Stretch);
+    tableWidget->setSelectionMode(QAbstractItemView::NoSelection);
+    tableWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    layout->addWidget(tableWidget);
+
+    QHBoxLayout *buttons = new QHBoxLayout();
+    buttonReset = new QPushButton(tr("&Reset"), contents);
+    buttonSave = new QPushButton(tr("&Save report..."), contents);
+    buttons->addStretch();
+    buttons->addWidget(buttonReset);
+    buttons->addWidget(buttonSave);
+    layout->addLayout(buttons);
+    setWidget(contents);
+
+    // the lag probe always runs so the status bar summary is meaningful
+    lagTimer.setInterval(lagInterval);
+    refreshTimer.setInterval(1000);
+
+    connect(&lagTimer, SIGNAL(timeout()), this, SLOT(probeLag()));
+    connect(&refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+    connect(buttonReset, SIGNAL(clicked()), this, SLOT(resetTimings()));
+    connect(buttonSave, SIGNAL(clicked()), this, SLOT(saveReport()));
+
+    lastProbe = Diagnostics::now();
+    lagTimer.start();
+    refreshTimer.start();
+}
+
+void DockDiagnostics::showEvent(QShowEvent *event)
+{
+    QDockWidget::showEvent(event);
+    refresh();
+}
+
+// SLOT triggered by the lag timer.
+// Anything over the timer's interval is time the event loop was busy
+void DockDiagnostics::probeLag()
+{
+    qint64 tnow = Diagnostics::now();
+    qint64 late = (tnow - lastProbe) - (qint64)lagInterval * 1000000;
+    lastProbe = tnow;
+    Diagnostics::record("gui: event loop lag", late);
+}
+
+void DockDiagnostics::refresh()
+{
+    emit summaryChanged(summary());
+    if (!isVisible())
+        return;
+
+    QStringList names = Diagnostics::names();
+    if (tableWidget->rowCount() != names.size()) {
+        tableWidget->setRowCount(names.size());
+        for (int row=0; row<names.size(); ++row) {
+            for (int col=0; col<5; ++col) {
+                QTableWidgetItem *item = new QTableWidgetItem();
+                if (col > 0)
+                    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                tableWidget->setItem(row, col, item);
+            }
+        }
+    }
+
+    for (int row=0; row<names.size(); ++row) {
+        Histogram h = Diagnostics::histogram(names.at(row));
+        tableWidget->item(row, 0)->setText(names.at(row));
+        tableWidget->item(row, 1)->setText(QString::number(h.count()));
+        tableWidget->item(row, 2)->setText(QString::number(h.percentile(0.5) / 1000.0, 'f', 1));
+        tableWidget->item(row, 3)->setText(QString::number(h.percentile(0.99) / 1000.0, 'f', 1));
+        tableWidget->item(row, 4)->setText(QString::number(h.max() / 1000.0, 'f', 1));
+    }
+}
+
+// the event loop lag and the worst query round trip
+QString DockDiagnostics::summary()
+{
+    Histogram lag = Diagnostics::histogram("gui: event loop lag");
+    quint64 worstQuery = 0;
+    QStringList names = Diagnostics::names();
+    QStringList::const_iterator iter = names.constBegin();
+    while (iter != names.constEnd()) {
+        if ((*iter).startsWith("query ") && (*iter).endsWith("final batch"))
+            worstQuery = qMax(worstQuery, Diagnostics::histogram(*iter).percentile(0.99));
+        ++iter;
+    }
+    return tr("Lag p99: %1 ms  Query p99: %2 ms")
+            .arg(lag.percentile(0.99) / 1000)
+            .arg(worstQuery / 1000);
+}
+
+// SLOT triggered when the Reset button is clicked
+void DockDiagnostics::resetTimings()
+{
+    Diagnostics::reset();
+    tableWidget->setRowCount(0);
+    refresh();
+}
+
+// SLOT triggered when the Save report button is clicked
+void DockDiagnostics::saveReport()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save timings"),
+                                                    "xview-timings.txt", tr("Text files (*.txt)"));
+    if (fileName.isEmpty())
+        return;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return;
+    QTextStream out(&file);
+    out << Diagnostics::report();
+}
@@ -0,0 +1,63 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef DOCKDIAGNOSTICS_H
+#define DOCKDIAGNOSTICS_H
+
+#include <QDockWidget>
+#include <QTableWidget>
+#include <QPushButton>
+#include <QTimer>
+
+// A dock panel that shows the percentiles of every recorded timing.
+// It also measures how late the gui event loop runs its timers.
+class DockDiagnostics : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit DockDiagnostics(QWidget *parent);
+
+    static const int lagInterval = 100; // msec between event loop probes
+
+signals:
+    // one line summary for the status bar
+    void summaryChanged(const QString &);
+
+protected:
+    void showEvent(QShowEvent *event);
+
+private slots:
+    void probeLag();
+    void refresh();
+    void resetTimings();
+    void saveReport();
+
+private:
+    QTableWidget *tableWidget;
+    QPushButton *buttonReset;
+    QPushButton *buttonSave;
+    QTimer lagTimer;
+    QTimer refreshTimer;
+    qint64 lastProbe;
+
+    QString summary();
+};
+
+#endif // DOCKDIAGNOSTICS_H
@@ -0,0 +1,139 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "dockleaderboard.h"
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include <QSettings>
+
+DockLeaderboard::DockLeaderboard(QWidget *parent, Leaderboard *board) :
+    QDockWidget(tr("Leaderboard"), parent),
+    leaderboard(board),
+    refreshTimer(),
+    dirty(true)
+{
+    setObjectName("Leaderboard");
+
+    QWidget *contents = new QWidget(this);
+    QVBoxLayout *layout = new QVBoxLayout(contents);
+    layout->setContentsMargins(2, 2, 2, 2);
+
+    comboMetric = new QComboBox(contents);
+    for (int i=0; i<leaderboard->metricCount(); ++i)
+        comboMetric->addItem(leaderboard->title(i));
+    layout->addWidget(comboMetric);
+
+    // the items are created once and reused on each refresh
+    tableWidget = new QTableWidget(rows, 2, contents);
+    tableWidget->setHorizontalHeaderLabels(QStringList() << tr("name") << tr("value"));
+    tableWidget->verticalHeader()->hide();
+    tableWidget->horizontalHeader()->setStretchLastSection(true);
+    tableWidget->setSelectionBehavior(QAbstractItemView::SelectRows);
+    tableWidget->setSelectionMode(QAbstractItemView::SingleSelection);
+    tableWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    for (int row=0; row<rows; ++row) {
+        tableWidget->setItem(row, 0, new QTableWidgetItem());
+        QTableWidgetItem *item = new QTableWidgetItem();
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        tableWidget->setItem(row, 1, item);
+    }
+    layout->addWidget(tableWidget);
+    setWidget(contents);
+
+    QSettings settings;
+    comboMetric->setCurrentIndex(settings.value("leaderboard/metric", 0).toInt());
+
+    // don't redraw on every sample. Once a second is plenty
+    refreshTimer.setInterval(1000);
+
+    connect(leaderboard, SIGNAL(changed()), this, SLOT(leaderboardChanged()));
+    connect(comboMetric, SIGNAL(currentIndexChanged(int)), this, SLOT(metricChanged()));
+    connect(&refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+    connect(tableWidget, SIGNAL(itemDoubleClicked(QTableWidgetItem*)), this, SLOT(activated(QTableWidgetItem*)));
+}
+
+DockLeaderboard::~DockLeaderboard()
+{
+    QSettings settings;
+    settings.setValue("leaderboard/metric", comboMetric->currentIndex());
+}
+
+void DockLeaderboard::showEvent(QShowEvent *event)
+{
+    QDockWidget::showEvent(event);
+    refresh();
+}
+
+// SLOT triggered when any ranking has been updated
+void DockLeaderboard::leaderboardChanged()
+{
+    dirty = true;
+    if (!refreshTimer.isActive())
+        refreshTimer.start();
+}
+
+// SLOT triggered when the user picks a different metric
+void DockLeaderboard::metricChanged()
+{
+    dirty = true;
+    refresh();
+}
+
+void DockLeaderboard::refresh()
+{
+    refreshTimer.stop();
+    if (!dirty || !isVisible())
+        return;
+    dirty = false;
+
+    int metric = comboMetric->currentIndex();
+    if (metric < 0)
+        return;
+
+    QList<Leaderboard::Entry> entries = leaderboard->top(metric, rows);
+    bool rate = leaderboard->isRate(metric);
+    for (int row=0; row<rows; ++row) {
+        QTableWidgetItem *itemName = tableWidget->item(row, 0);
+        QTableWidgetItem *itemValue = tableWidget->item(row, 1);
+        if (row < entries.size()) {
+            const Leaderboard::Entry &entry = entries.at(row);
+            if (itemName->text() != entry.first)
+                itemName->setText(entry.first);
+            itemValue->setText(rate ? QString::number(entry.second, 'f', 2)
+                                    : QString::number((qint64)entry.second));
+        } else {
+            itemName->setText(QString());
+            itemValue->setText(QString());
+        }
+    }
+}
+
+// SLOT triggered when a row is double clicked
+void DockLeaderboard::activated(QTableWidgetItem *item)
+{
+    int metric = comboMetric->currentIndex();
+    QString name = tableWidget->item(item->row(), 0)->text();
+    if (metric < 0 || name.isEmpty())
+        return;
+
+    ObjectListModel *model = leaderboard->model(metric);
+    int row = model->findRow(name);
+    if (row >= 0)
+        emit setCurrentObject(model->qmfData(row), leaderboard->qmfClass(metric));
+}
@@ -0,0 +1,61 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef DOCKLEADERBOARD_H
+#define DOCKLEADERBOARD_H
+
+#include <QDockWidget>
+#include <QComboBox>
+#include <QTableWidget>
+#include <QTimer>
+#include "leaderboard.h"
+
+// A dock panel that shows the top objects for one leaderboard metric
+class DockLeaderboard : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit DockLeaderboard(QWidget *parent, Leaderboard *leaderboard);
+    ~DockLeaderboard();
+
+    static const int rows = 10;
+
+signals:
+    // user picked an object
+    void setCurrentObject(const qmf::Data&, const QString &);
+
+protected:
+    void showEvent(QShowEvent *event);
+
+private slots:
+    void leaderboardChanged();
+    void metricChanged();
+    void refresh();
+    void activated(QTableWidgetItem *item);
+
+private:
+    Leaderboard *leaderboard;
+    QComboBox *comboMetric;
+    QTableWidget *tableWidget;
+    QTimer refreshTimer;
+    bool dirty;
+};
+
+#endif // DOCKLEADERBOARD_H
@@ -0,0 +1,268 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "expression.h"
+#include <QVarLengthArray>
+
+Expression::Expression() :
+    program(),
+    source(),
+    depth(0),
+    pos(0),
+    stack(0)
+{
+}
+
+bool Expression::compile(const QString& text, QString *error)
+{
+    program.clear();
+    source = text.trimmed();
+    parseText = source;
+    parseError.clear();
+    pos = 0;
+    depth = 0;
+    stack = 0;
+
+    bool ok = parseSum();
+    skipSpace();
+    if (ok && pos < parseText.size()) {
+        parseError = QString("unexpected '%1' at column %2").arg(parseText.at(pos)).arg(pos + 1);
+        ok = false;
+    }
+    if (!ok) {
+        program.clear();
+        if (error)
+            *error = parseError;
+    }
+    parseText.clear();
+    return ok;
+}
+
+QStringList Expression::properties() const
+{
+    QStringList list;
+    QVector<Op>::const_iterator iter = program.constBegin();
+    while (iter != program.constEnd()) {
+        if (!iter->property.isEmpty() && !list.contains(iter->property))
+            list.append(iter->property);
+        ++iter;
+    }
+    return list;
+}
+
+bool Expression::usesRate() const
+{
+    QVector<Op>::const_iterator iter = program.constBegin();
+    while (iter != program.constEnd()) {
+        if (iter->code == opRate || iter->code == opRate1m || iter->code == opRate5m)
+            return true;
+        ++iter;
+    }
+    return false;
+}
+
+qreal Expression::evaluate(const Sample& current) const
+{
+    QVarLengthArray<qreal, 16> values(depth);
+    int top = 0;
+
+    QVector<Op>::const_iterator iter = program.constBegin();
+    while (iter != program.constEnd()) {
+        switch (iter->code) {
+        case opNumber:
+            values[top++] = iter->number;
+            break;
+        case opProperty:
+            values[top++] = (qreal)current.data(iter->property);
+            break;
+        case opRate:
+            values[top++] = current.rate(iter->property).instant;
+            break;
+        case opRate1m:
+            values[top++] = current.rate(iter->property).avg1m;
+            break;
+        case opRate5m:
+            values[top++] = current.rate(iter->property).avg5m;
+            break;
+        case opAdd:
+            --top;
+            values[top - 1] += values[top];
+            break;
+        case opSub:
+            --top;
+            values[top - 1] -= values[top];
+            break;
+        case opMul:
+            --top;
+            values[top - 1] *= values[top];
+            break;
+        case opDiv:
+            --top;
+            values[top - 1] = values[top] == 0.0 ? 0.0 : values[top - 1] / values[top];
+            break;
+        case opNegate:
+            values[top - 1] = -values[top - 1];
+            break;
+        }
+        ++iter;
+    }
+    return top > 0 ? values[top - 1] : 0.0;
+}
+
+// keep track of the stack depth the program will need
+void Expression::emitOp(const Op& op)
+{
+    switch (op.code) {
+    case opNumber:
+    case opProperty:
+    case opRate:
+    case opRate1m:
+    case opRate5m:
+        ++stack;
+        if (stack > depth)
+            depth = stack;
+        break;
+    case opNegate:
+        break;
+    default:
+        --stack;
+        break;
+    }
+    program.append(op);
+}
+
+void Expression::skipSpace()
+{
+    while (pos < parseText.size() && parseText.at(pos).isSpace())
+        ++pos;
+}
+
+bool Expression::parseIdentifier(QString& identifier)
+{
+    int start = pos;
+    while (pos < parseText.size() && (parseText.at(pos).isLetterOrNumber() || parseText.at(pos) == '_'))
+        ++pos;
+    identifier = parseText.mid(start, pos - start);
+    return !identifier.isEmpty();
+}
+
+// sum := product (('+' | '-') product)*
+bool Expression::parseSum()
+{
+    if (!parseProduct())
+        return false;
+    skipSpace();
+    while (pos < parseText.size() && (parseText.at(pos) == '+' || parseText.at(pos) == '-')) {
+        QChar op = parseText.at(pos++);
+        if (!parseProduct())
+            return false;
+        emitOp(Op(op == '+' ? opAdd : opSub));
+        skipSpace();
+    }
+    return true;
+}
+
+// product := factor (('*' | '/') factor)*
+bool Expression::parseProduct()
+{
+    if (!parseFactor())
+        return false;
+    skipSpace();
+    while (pos < parseText.size() && (parseText.at(pos) == '*' || parseText.at(pos) == '/')) {
+        QChar op = parseText.at(pos++);
+        if (!parseFactor())
+            return false;
+        emitOp(Op(op == '*' ? opMul : opDiv));
+        skipSpace();
+    }
+    return true;
+}
+
+// factor := number | property | rate '(' property ')' | '(' sum ')' | '-' factor
+// rate may also be rate1m or rate5m
+bool Expression::parseFactor()
+{
+    skipSpace();
+    if (pos >= parseText.size()) {
+        parseError = "unexpected end of expression";
+        return false;
+    }
+
+    QChar c = parseText.at(pos);
+    if (c == '-') {
+        ++pos;
+        if (!parseFactor())
+            return false;
+        emitOp(Op(opNegate));
+        return true;
+    }
+    if (c == '(') {
+        ++pos;
+        if (!parseSum())
+            return false;
+        skipSpace();
+        if (pos >= parseText.size() || parseText.at(pos) != ')') {
+            parseError = QString("missing ')' at column %1").arg(pos + 1);
+            return false;
+        }
+        ++pos;
+        return true;
+    }
+    if (c.isDigit() || c == '.') {
+        int start = pos;
+        while (pos < parseText.size() && (parseText.at(pos).isDigit() || parseText.at(pos) == '.'))
+            ++pos;
+        bool ok;
+        qreal number = parseText.mid(start, pos - start).toDouble(&ok);
+        if (!ok) {
+            parseError = QString("bad number at column %1").arg(start + 1);
+            return false;
+        }
+        emitOp(Op(opNumber, number));
+        return true;
+    }
+
+    QString identifier;
+    if (!parseIdentifier(identifier)) {
+        parseError = QString("unexpected '%1' at column %2").arg(c).arg(pos + 1);
+        return false;
+    }
+    skipSpace();
+    bool isRate = identifier == "rate" || identifier == "rate1m" || identifier == "rate5m";
+    if (isRate && pos < parseText.size() && parseText.at(pos) == '(') {
+        ++pos;
+        skipSpace();
+        QString property;
+        if (!parseIdentifier(property)) {
+            parseError = QString("expected a property name at column %1").arg(pos + 1);
+            return false;
+        }
+        skipSpace();
+        if (pos >= parseText.size() || parseText.at(pos) != ')') {
+            parseError = QString("missing ')' at column %1").arg(pos + 1);
+            return false;
+        }
+        ++pos;
+        OpCode code = identifier == "rate1m" ? opRate1m : (identifier == "rate5m" ? opRate5m : opRate);
+        emitOp(Op(code, 0.0, property));
+        return true;
+    }
+    emitOp(Op(opProperty, 0.0, identifier));
+    return true;
+}
@@ -0,0 +1,79 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "sample.h"
+
+// An arithmetic expression over the sampled properties of an object.
+// The text is compiled once into a postfix program, so evaluating it
+// for each new sample is a single pass with no parsing.
+//
+// Supports numbers, property names, + - * /, unary minus, parentheses
+// and rate(property), the change per second since the previous sample.
+// rate1m(property) and rate5m(property) are the 1 and 5 minute averages.
+//   rate1m(msgTotalEnqueues) - rate1m(msgTotalDequeues)
+class Expression
+{
+public:
+    Expression();
+
+    bool compile(const QString& text, QString *error = 0);
+    bool isValid() const { return !program.isEmpty(); }
+    const QString& text() const { return source; }
+
+    // the properties the expression reads
+    QStringList properties() const;
+    // true if any of them are read through rate(), rate1m() or rate5m()
+    bool usesRate() const;
+
+    // the rates are the ones the model stored in the sample
+    qreal evaluate(const Sample& current) const;
+
+private:
+    enum OpCode { opNumber, opProperty, opRate, opRate1m, opRate5m, opAdd, opSub, opMul, opDiv, opNegate };
+    struct Op {
+        Op(OpCode c = opNumber, qreal n = 0.0, const QString& p = QString()) : code(c), number(n), property(p) { }
+        OpCode code;
+        qreal number;
+        QString property;
+    };
+    QVector<Op> program;
+    QString source;
+    int depth;  // largest stack needed to evaluate the program
+
+    // recursive descent parser state
+    QString parseText;
+    int pos;
+    int stack;
+    QString parseError;
+
+    bool parseSum();
+    bool parseProduct();
+    bool parseFactor();
+    void skipSpace();
+    bool parseIdentifier(QString& identifier);
+    void emitOp(const Op& op);
+};
+
+#endif // EXPRESSION_H
@@ -0,0 +1,226 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "filter-model.h"
+
+static const int gramSize = 3;
+static const int debounceMsecs = 150;
+
+ObjectFilterProxyModel::ObjectFilterProxyModel(QObject *parent) :
+    QSortFilterProxyModel(parent),
+    nameCount(),
+    trigrams(),
+    matches(),
+    filterText(),
+    pendingText(),
+    debounce(this)
+{
+    debounce.setSingleShot(true);
+    debounce.setInterval(debounceMsecs);
+    connect(&debounce, SIGNAL(timeout()), this, SLOT(applyFilter()));
+
+    // the source model updates every row on each poll. The names don't
+    // change, so there is no need to re-filter when that happens
+    setDynamicSortFilter(false);
+    setFilterKeyColumn(0);
+}
+
+void ObjectFilterProxyModel::setSourceModel(QAbstractItemModel *model)
+{
+    QAbstractItemModel *old = sourceModel();
+    if (old)
+        disconnect(old, 0, this, 0);
+
+    QSortFilterProxyModel::setSourceModel(model);
+
+    connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)),
+            this, SLOT(sourceRowsInserted(QModelIndex,int,int)));
+    connect(model, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+            this, SLOT(sourceRowsAboutToBeRemoved(QModelIndex,int,int)));
+    connect(model, SIGNAL(modelReset()), this, SLOT(sourceReset()));
+
+    indexSource();
+}
+
+// SLOT triggered when the user types in the filter line edit
+void ObjectFilterProxyModel::setFilterText(const QString &text)
+{
+    pendingText = text;
+
+    // clearing the filter should be immediate
+    if (text.isEmpty()) {
+        debounce.stop();
+        applyFilter();
+    } else
+        debounce.start();
+}
+
+void ObjectFilterProxyModel::applyFilter()
+{
+    QString text = pendingText.toLower();
+    if (text == filterText)
+        return;
+
+    QSet<QString> next;
+    if (!text.isEmpty()) {
+        if (!filterText.isEmpty() && text.contains(filterText)) {
+            // the new filter is narrower than the old one.
+            // Only the previous matches need to be checked
+            QSet<QString>::const_iterator iter = matches.constBegin();
+            while (iter != matches.constEnd()) {
+                if ((*iter).contains(text))
+                    next.insert(*iter);
+                ++iter;
+            }
+        } else
+            next = candidates(text);
+    }
+    filterText = text;
+    matches = next;
+
+    invalidateFilter();
+}
+
+bool ObjectFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &) const
+{
+    if (filterText.isEmpty())
+        return true;
+
+    QString name = rowName(sourceRow).toLower();
+    if (matches.contains(name))
+        return true;
+
+    // The base class filters newly inserted rows before we get the
+    // rowsInserted signal, so they are not in the index yet
+    if (!nameCount.contains(name))
+        return name.contains(filterText);
+
+    return false;
+}
+
+QString ObjectFilterProxyModel::rowName(int sourceRow) const
+{
+    QAbstractItemModel *model = sourceModel();
+    return model->data(model->index(sourceRow, 0)).toString();
+}
+
+// Return the indexed names that contain text
+QSet<QString> ObjectFilterProxyModel::candidates(const QString &text) const
+{
+    QSet<QString> found;
+
+    if (text.length() < gramSize) {
+        // too short to use the index
+        QHash<QString, int>::const_iterator iter = nameCount.constBegin();
+        while (iter != nameCount.constEnd()) {
+            if (iter.key().contains(text))
+                found.insert(iter.key());
+            ++iter;
+        }
+        return found;
+    }
+
+    // find the trigram of the filter string with the fewest names
+    const QSet<QString> *smallest = 0;
+    for (int i=0; i<=text.length() - gramSize; ++i) {
+        QHash<QString, QSet<QString> >::const_iterator posting = trigrams.constFind(text.mid(i, gramSize));
+        if (posting == trigrams.constEnd())
+            return found;
+        if (!smallest || posting.value().size() < smallest->size())
+            smallest = &posting.value();
+    }
+
+    // and verify each of its names against the full string
+    QSet<QString>::const_iterator iter = smallest->constBegin();
+    while (iter != smallest->constEnd()) {
+        if ((*iter).contains(text))
+            found.insert(*iter);
+        ++iter;
+    }
+    return found;
+}
+
+void ObjectFilterProxyModel::addName(const QString &name)
+{
+    QString lower = name.toLower();
+    int count = nameCount.value(lower, 0);
+    nameCount[lower] = count + 1;
+    if (count > 0)
+        return;
+
+    for (int i=0; i<=lower.length() - gramSize; ++i)
+        trigrams[lower.mid(i, gramSize)].insert(lower);
+
+    if (!filterText.isEmpty() && lower.contains(filterText))
+        matches.insert(lower);
+}
+
+void ObjectFilterProxyModel::removeName(const QString &name)
+{
+    QString lower = name.toLower();
+    QHash<QString, int>::iterator count = nameCount.find(lower);
+    if (count == nameCount.end())
+        return;
+    if (--count.value() > 0)
+        return;
+    nameCount.erase(count);
+
+    for (int i=0; i<=lower.length() - gramSize; ++i) {
+        QHash<QString, QSet<QString> >::iterator posting = trigrams.find(lower.mid(i, gramSize));
+        if (posting != trigrams.end()) {
+            posting.value().remove(lower);
+            if (posting.value().isEmpty())
+                trigrams.erase(posting);
+        }
+    }
+    matches.remove(lower);
+}
+
+void ObjectFilterProxyModel::indexSource()
+{
+    nameCount.clear();
+    trigrams.clear();
+    matches.clear();
+
+    QAbstractItemModel *model = sourceModel();
+    if (!model)
+        return;
+
+    for (int row=0; row<model->rowCount(); ++row)
+        addName(rowName(row));
+}
+
+// SLOT triggered after the source model has added rows
+void ObjectFilterProxyModel::sourceRowsInserted(const QModelIndex &, int first, int last)
+{
+    for (int row=first; row<=last; ++row)
+        addName(rowName(row));
+}
+
+// SLOT triggered before the source model removes rows
+void ObjectFilterProxyModel::sourceRowsAboutToBeRemoved(const QModelIndex &, int first, int last)
+{
+    for (int row=first; row<=last; ++row)
+        removeName(rowName(row));
+}
+
+void ObjectFilterProxyModel::sourceReset()
+{
+    indexSource();
+}
@@ -0,0 +1,74 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef FILTERMODEL_H
+#define FILTERMODEL_H
+
+#include <QSortFilterProxyModel>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+
+// Filters the object list in the selection dialogs by name.
+// The object names are kept in a trigram index that is updated as
+// rows are added to and removed from the source model, so a new
+// filter string only has to look at the names that share its trigrams.
+// When the user extends the current filter string, only the names that
+// matched the previous string are checked again.
+class ObjectFilterProxyModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+public:
+    explicit ObjectFilterProxyModel(QObject *parent = 0);
+
+    void setSourceModel(QAbstractItemModel *sourceModel);
+
+public slots:
+    // restarts the debounce timer. The filter is applied once typing pauses
+    void setFilterText(const QString &text);
+    void applyFilter();
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const;
+
+private slots:
+    void sourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void sourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void sourceReset();
+
+private:
+    QString rowName(int sourceRow) const;
+    void addName(const QString &name);
+    void removeName(const QString &name);
+    void indexSource();
+    QSet<QString> candidates(const QString &text) const;
+
+    // lower case name -> number of rows with that name
+    QHash<QString, int> nameCount;
+    // trigram -> lower case names containing it
+    QHash<QString, QSet<QString> > trigrams;
+
+    // names that match the current filter
+    QSet<QString> matches;
+    QString filterText;
+    QString pendingText;
+    QTimer debounce;
+};
+
+#endif // FILTERMODEL_H
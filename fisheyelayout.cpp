@@ -20,8 +20,12 @@
 #include "fisheyelayout.h"
 #include "widgetqmfobject.h"
 
+// sections with less than this much showing are treated as hidden
+const qreal FisheyeLayout::minVisibleFraction = 0.25;
+
 FisheyeLayout::FisheyeLayout(QWidget *parent, bool tile) :
-        QLayout(parent), tiled(tile)
+        QLayout(parent), tiled(tile), animated(true), overlay(0),
+        lastFocused(-2), lastTiled(tile)
 {
     setMargin(0);
     setSpacing(0);
@@ -31,6 +35,11 @@ void FisheyeLayout::setCascade(bool cascade)
     tiled = !cascade;
 }
 
+void FisheyeLayout::setAnimated(bool animate)
+{
+    animated = animate;
+}
+
 int FisheyeLayout::count() const
 {
         // QList::size() returns the number of QLayoutItems in the list
@@ -83,22 +92,33 @@ QSize FisheyeLayout::minimumSize() const
     return s + n*QSize(spacing(), spacing());
 }
 
-void FisheyeLayout::setTiledGeometry(const QRect &r)
+// The items whose sections are shown, in order. Hidden sections take no space
+QList<int> FisheyeLayout::shownItems() const
 {
-    if (list.size() == 0)
-        return;
+    QList<int> shown;
+    for (int i=0; i<list.size(); ++i)
+        if (!list.at(i)->widget()->isHidden())
+            shown.append(i);
+    return shown;
+}
 
+void FisheyeLayout::setTiledGeometry(const QRect &r)
+{
     setToolTips(0, false);
 
-    int w = r.width() / list.size();
-    int i = 0;
-    while (i < list.size()) {
-        QRect geom(w * i, 0, w, r.height());
+    QList<int> shown = shownItems();
+    if (shown.isEmpty())
+        return;
 
-        startGeometryAnimation(list.at(i), geom);
-        //list.at(i)->setGeometry(geom);
-        ++i;
-    }
+    // hidden items stay where they were
+    QList<QRect> targets;
+    for (int i=0; i<list.size(); ++i)
+        targets.append(list.at(i)->geometry());
+
+    int w = r.width() / shown.size();
+    for (int rank=0; rank<shown.size(); ++rank)
+        targets[shown.at(rank)] = QRect(w * rank, 0, w, r.height());
+    moveItems(targets, -1);
 }
 
 void FisheyeLayout::setGeometry(const QRect &r)
@@ -111,11 +131,18 @@ void FisheyeLayout::setGeometry(const QRect &r)
     if (tiled)
         return setTiledGeometry(r);
 
+    QList<int> shown = shownItems();
+    if (shown.isEmpty())
+        return;
+
     int focusedItem = getFocusedItem();
     if (focusedItem < 0)
         focusedItem = getCurrentItem();
     if (focusedItem == -1)
         return;
+    // the current section may have been hidden from the View menu
+    if (!shown.contains(focusedItem))
+        focusedItem = shown.first();
     setToolTips(focusedItem, true);
 
     //
@@ -135,47 +162,144 @@ void FisheyeLayout::setGeometry(const QRect &r)
     }
     list.at(focusedItem)->widget()->raise();
 
-    if (list.size() > 1) {
+    if (shown.size() > 1) {
+        QList<QRect> targets;
+        for (i=0; i<list.size(); ++i)
+            targets.append(list.at(i)->geometry());
+
         QRect geom = QRect();
-        int xGap = (r.width() * 0.1) / (list.size() - 1);
-        int yGap = (r.height() * 0.1) / (list.size() - 1);
+        int xGap = (r.width() * 0.1) / (shown.size() - 1);
+        int yGap = (r.height() * 0.1) / (shown.size() - 1);
+        int focusedRank = shown.indexOf(focusedItem);
         int diff;
-        i = 0;
-        while (i < list.size()) {
-            QLayoutItem *o = list.at(i);
-
-            diff = qAbs(i - focusedItem);
-            geom.setLeft(i * xGap);
+        int rank = 0;
+        while (rank < shown.size()) {
+            diff = qAbs(rank - focusedRank);
+            geom.setLeft(rank * xGap);
             geom.setTop(diff * yGap);
             geom.setWidth(r.width() * 0.9);
             geom.setHeight(r.height() - diff * yGap * 2);
 
-            startGeometryAnimation(o, geom);
-            //o->setGeometry(geom);
-            ++i;
+            targets[shown.at(rank)] = geom;
+            ++rank;
         }
+        moveItems(targets, focusedItem);
     } else {
-        list.at(0)->setGeometry(QRect(0, 0, r.width(), r.height()));
+        list.at(shown.first())->setGeometry(QRect(0, 0, r.width(), r.height()));
+        updateOcclusion();
     }
 }
 
-void FisheyeLayout::startGeometryAnimation(QLayoutItem *o, const QRect& geom)
+// Put the items at their new geometries.
+// When the focus or the layout mode changes, the change is animated.
+// A plain resize of the window is applied directly.
+void FisheyeLayout::moveItems(const QList<QRect>& targets, int focusedItem)
 {
-    QPropertyAnimation *animation;
-    if (!animationHash.contains(o)) {
-        animation = new QPropertyAnimation(o->widget(), "geometry");
-        animationHash[o] = animation;
-    } else {
-        animation = animationHash[o];
+    bool rearranged = (focusedItem != lastFocused) || (tiled != lastTiled);
+    bool firstTime = (lastFocused == -2);
+    lastFocused = focusedItem;
+    lastTiled = tiled;
+
+    if (!animated || !rearranged || firstTime || !parentWidget() || !parentWidget()->isVisible()) {
+        if (overlay && overlay->isRunning())
+            startTransition(targets);
+        else
+            applyGeometry(targets);
+        return;
     }
-    animation->setDuration(500);
-    animation->setStartValue(o->widget()->geometry());
-    animation->setEndValue(geom);
-    animation->setEasingCurve(QEasingCurve::OutBack);
+    startTransition(targets);
+}
 
-    animation->start();
+void FisheyeLayout::applyGeometry(const QList<QRect>& targets)
+{
+    for (int i=0; i<list.size(); ++i)
+        list.at(i)->setGeometry(targets.at(i));
+    updateOcclusion();
 }
 
+// Work out how much of each section is actually visible and tell the
+// sections that are mostly covered by their siblings so they can skip
+// querying and painting until they come back into view.
+void FisheyeLayout::updateOcclusion()
+{
+    if (!parentWidget())
+        return;
+
+    // the parent's children are in stacking order, the last one is on top
+    QList<QWidget *> stack;
+    QObjectList children = parentWidget()->children();
+    QObjectList::const_iterator iter = children.constBegin();
+    while (iter != children.constEnd()) {
+        for (int i=0; i<list.size(); ++i)
+            if (list.at(i)->widget() == *iter)
+                stack.append(list.at(i)->widget());
+        ++iter;
+    }
+
+    for (int i=0; i<stack.size(); ++i) {
+        WidgetQmfObject *w = (WidgetQmfObject *)stack.at(i);
+        QRect geom = w->geometry();
+        int area = geom.width() * geom.height();
+        if (w->isHidden() || area <= 0) {
+            w->setOccluded(true);
+            continue;
+        }
+
+        QRegion visible(geom);
+        for (int above=i+1; above<stack.size(); ++above)
+            if (!stack.at(above)->isHidden())
+                visible -= QRegion(stack.at(above)->geometry());
+
+        int visibleArea = 0;
+        QVector<QRect> rects = visible.rects();
+        QVector<QRect>::const_iterator iRect = rects.constBegin();
+        while (iRect != rects.constEnd()) {
+            visibleArea += (*iRect).width() * (*iRect).height();
+            ++iRect;
+        }
+        w->setOccluded((qreal)visibleArea / area < minVisibleFraction);
+    }
+}
+
+// Snapshot each section and animate the snapshots on an overlay.
+// The real widgets get their final geometry just once, before the snapshots
+void FisheyeLayout::startTransition(const QList<QRect>& targets)
+{
+    if (!overlay)
+        overlay = new FisheyeOverlay(parentWidget());
+
+    // start from wherever the items appear to be now
+    QList<QRect> from;
+    for (int i=0; i<list.size(); ++i) {
+        int drawn = overlay->isRunning() ? overlayOrder.indexOf(i) : -1;
+        from.append(drawn >= 0 ? overlay->currentRect(drawn) : list.at(i)->widget()->geometry());
+    }
+
+    applyGeometry(targets);
+
+    // paint the snapshots in the widgets' stacking order
+    overlayOrder.clear();
+    QObjectList children = parentWidget()->children();
+    QObjectList::const_iterator iter = children.constBegin();
+    while (iter != children.constEnd()) {
+        for (int i=0; i<list.size(); ++i)
+            if (list.at(i)->widget() == *iter && !list.at(i)->widget()->isHidden())
+                overlayOrder.append(i);
+        ++iter;
+    }
+
+    QList<QPixmap> pixmaps;
+    QList<QRect> fromOrdered;
+    QList<QRect> toOrdered;
+    QList<int>::const_iterator iOrder = overlayOrder.constBegin();
+    while (iOrder != overlayOrder.constEnd()) {
+        pixmaps.append(QPixmap::grabWidget(list.at(*iOrder)->widget()));
+        fromOrdered.append(from.at(*iOrder));
+        toOrdered.append(targets.at(*iOrder));
+        ++iOrder;
+    }
+    overlay->start(pixmaps, fromOrdered, toOrdered, 500);
+}
 
 int FisheyeLayout::getFocusedItem()
 {
@@ -222,8 +346,6 @@ FisheyeLayout::~FisheyeLayout()
 {
      QLayoutItem *item;
      while ((item = takeAt(0))) {
-         if (animationHash.contains(item))
-             delete animationHash[item];
          delete item;
     }
 }
@@ -21,12 +21,13 @@
 #define FISHEYELAYOUT_H
 
 #include <QtGui>
+#include "fisheyeoverlay.h"
 
 class FisheyeLayout : public QLayout
 {
     Q_OBJECT
 public:
-    FisheyeLayout(): QLayout() {}
+    FisheyeLayout(): QLayout(), tiled(false), animated(true), overlay(0), lastFocused(-2), lastTiled(false) {}
     FisheyeLayout(QWidget *parent, bool tile=false);
     ~FisheyeLayout();
 
@@ -40,19 +41,29 @@ public:
 
 public slots:
     void setCascade(bool cascade);
+    void setAnimated(bool animate);
 
 protected:
     int getFocusedItem();
     int getCurrentItem();
     void setToolTips(int current, bool set);
     void setTiledGeometry(const QRect &r);
-    void startGeometryAnimation(QLayoutItem *o, const QRect& geom);
+    void moveItems(const QList<QRect>& targets, int focusedItem);
+    void applyGeometry(const QList<QRect>& targets);
+    void startTransition(const QList<QRect>& targets);
+    void updateOcclusion();
+    QList<int> shownItems() const;
 
 
 private:
+    static const qreal minVisibleFraction;
     QList<QLayoutItem*> list;
-    QHash<QLayoutItem*, QPropertyAnimation*> animationHash;
     bool tiled;
+    bool animated;
+    FisheyeOverlay *overlay;
+    QList<int> overlayOrder;    // overlay paint order -> item index
+    int lastFocused;            // focused item of the last arrangement, -2 before the first
+    bool lastTiled;
 
 };
 
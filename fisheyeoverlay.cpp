@@ -0,0 +1,84 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "fisheyeoverlay.h"
+
+FisheyeOverlay::FisheyeOverlay(QWidget *parent) :
+    QWidget(parent),
+    animation(this, "progress"),
+    _progress(1.0)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    hide();
+
+    animation.setStartValue(0.0);
+    animation.setEndValue(1.0);
+    animation.setEasingCurve(QEasingCurve::OutBack);
+    connect(&animation, SIGNAL(finished()), this, SLOT(finished()));
+}
+
+void FisheyeOverlay::start(const QList<QPixmap>& pixmaps, const QList<QRect>& from, const QList<QRect>& to, int duration)
+{
+    animation.stop();
+    pixmapList = pixmaps;
+    fromList = from;
+    toList = to;
+    _progress = 0.0;
+
+    setGeometry(parentWidget()->rect());
+    raise();
+    show();
+
+    animation.setDuration(duration);
+    animation.start();
+}
+
+QRect FisheyeOverlay::currentRect(int i) const
+{
+    const QRect& from = fromList.at(i);
+    const QRect& to = toList.at(i);
+    return QRect(from.x() + qRound((to.x() - from.x()) * _progress),
+                 from.y() + qRound((to.y() - from.y()) * _progress),
+                 from.width() + qRound((to.width() - from.width()) * _progress),
+                 from.height() + qRound((to.height() - from.height()) * _progress));
+}
+
+void FisheyeOverlay::setProgress(qreal p)
+{
+    _progress = p;
+    update();
+}
+
+void FisheyeOverlay::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().window());
+
+    for (int i=0; i<pixmapList.size(); ++i)
+        painter.drawPixmap(currentRect(i), pixmapList.at(i));
+}
+
+// SLOT triggered when the animation is done
+// The real widgets are already in place underneath
+void FisheyeOverlay::finished()
+{
+    hide();
+    pixmapList.clear();
+}
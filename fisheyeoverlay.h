@@ -0,0 +1,58 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef FISHEYEOVERLAY_H
+#define FISHEYEOVERLAY_H
+
+#include <QtGui>
+
+// Covers the sections while the fisheye layout changes.
+// Pixmaps of the sections are moved and scaled from their old to their
+// new positions, so the real widgets are laid out and painted only once.
+class FisheyeOverlay : public QWidget
+{
+    Q_OBJECT
+    Q_PROPERTY(qreal progress READ progress WRITE setProgress)
+
+public:
+    explicit FisheyeOverlay(QWidget *parent);
+
+    // pixmaps are painted in list order, bottom to top
+    void start(const QList<QPixmap>& pixmaps, const QList<QRect>& from, const QList<QRect>& to, int duration);
+    bool isRunning() const { return animation.state() == QAbstractAnimation::Running; }
+    QRect currentRect(int i) const;
+
+    qreal progress() const { return _progress; }
+    void setProgress(qreal p);
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private slots:
+    void finished();
+
+private:
+    QPropertyAnimation animation;
+    qreal _progress;
+    QList<QPixmap> pixmapList;
+    QList<QRect> fromList;
+    QList<QRect> toList;
+};
+
+#endif // FISHEYEOVERLAY_H
@@ -0,0 +1,89 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "histogram.h"
+#include <math.h>
+
+Histogram::Histogram() :
+    buckets(bucketFor(Q_UINT64_C(0xffffffffffffffff)) + 1, 0),
+    total(0), sum(0), minimum(0), maximum(0)
+{
+}
+
+void Histogram::record(quint64 value)
+{
+    ++buckets[bucketFor(value)];
+    if (total == 0 || value < minimum)
+        minimum = value;
+    if (value > maximum)
+        maximum = value;
+    sum += value;
+    ++total;
+}
+
+void Histogram::reset()
+{
+    buckets.fill(0);
+    total = sum = minimum = maximum = 0;
+}
+
+quint64 Histogram::percentile(double p) const
+{
+    if (total == 0)
+        return 0;
+
+    quint64 wanted = (quint64)ceil(qBound(0.0, p, 1.0) * total);
+    if (wanted == 0)
+        wanted = 1;
+
+    quint64 seen = 0;
+    for (int i=0; i<buckets.size(); ++i) {
+        seen += buckets.at(i);
+        if (seen >= wanted)
+            return qMin(highestIn(i), maximum);
+    }
+    return maximum;
+}
+
+// values below linear map to themselves. Above that, the bucket is
+// found from the position of the highest set bit and the next 3 bits
+int Histogram::bucketFor(quint64 value)
+{
+    if (value < (quint64)linear)
+        return (int)value;
+
+    int msb = 0;
+    quint64 v = value;
+    while (v >>= 1)
+        ++msb;
+
+    int shift = msb - 3;
+    int top = (int)(value >> shift);    // 8 .. 15
+    return linear + (shift - 1) * subBuckets + (top - subBuckets);
+}
+
+quint64 Histogram::highestIn(int bucket)
+{
+    if (bucket < linear)
+        return bucket;
+
+    int shift = (bucket - linear) / subBuckets + 1;
+    quint64 top = (bucket - linear) % subBuckets + subBuckets;
+    return ((top + 1) << shift) - 1;
+}
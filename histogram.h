@@ -0,0 +1,61 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <QVector>
+#include <QtGlobal>
+
+// A log-linear latency histogram in the style of HdrHistogram.
+// Values up to 16 are counted exactly. Above that each power of two is
+// split into 8 buckets, so any reported value is within 12.5% of the
+// recorded one while the whole range of a 64 bit value fits in a few
+// hundred counters. Recording is O(1) and never allocates.
+class Histogram
+{
+public:
+    Histogram();
+
+    void record(quint64 value);
+    void reset();
+
+    quint64 count() const { return total; }
+    quint64 min() const { return total ? minimum : 0; }
+    quint64 max() const { return maximum; }
+    double mean() const { return total ? (double)sum / total : 0.0; }
+
+    // the value below which fraction p (0..1) of the recorded values fall
+    quint64 percentile(double p) const;
+
+private:
+    static const int linear = 16;   // values below this have their own bucket
+    static const int subBuckets = 8; // buckets per power of two above that
+
+    static int bucketFor(quint64 value);
+    static quint64 highestIn(int bucket);
+
+    QVector<quint64> buckets;
+    quint64 total;
+    quint64 sum;
+    quint64 minimum;
+    quint64 maximum;
+};
+
+#endif // HISTOGRAM_H
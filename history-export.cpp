@@ -0,0 +1,317 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "history-export.h"
+#include <QFile>
+#include <QDateTime>
+#include <QSet>
+#include <QTextStream>
+#include <QVector>
+#include <queue>
+#include <vector>
+#include <functional>
+
+namespace {
+
+// the next unread sample of one object. The stored samples come first,
+// up to the oldest sample in memory
+struct Cursor {
+    QString name;
+    ObjectListModel::SampleList stored;     // the chunk being read from the store
+    int storedIndex;
+    qint64 nextMSecs;                       // where the next chunk starts
+    qint64 cutoffMSecs;                     // the memory takes over from here
+    ObjectListModel::const_iterSampleList iter;
+    ObjectListModel::const_iterSampleList end;
+
+    const Sample &sample() const { return storedIndex < stored.size() ? stored.at(storedIndex) : *iter; }
+};
+
+// every object holds a chunk of its stored samples while the merge runs
+const qint64 storedChunkMSecs = 5 * 60 * 1000;
+
+// Read the next non-empty chunk of an object's stored samples
+bool readStored(Cursor &cursor, SegmentStore *store)
+{
+    cursor.stored.clear();
+    cursor.storedIndex = 0;
+    while (cursor.nextMSecs < cursor.cutoffMSecs) {
+        qint64 to = qMin(cursor.nextMSecs + storedChunkMSecs, cursor.cutoffMSecs) - 1;
+        cursor.stored = store->read(cursor.name, cursor.nextMSecs, to);
+        cursor.nextMSecs = to + 1;
+        if (!cursor.stored.isEmpty())
+            return true;
+    }
+    return false;
+}
+
+// Move to the object's next sample, false when there are none left
+bool advance(Cursor &cursor, SegmentStore *store)
+{
+    if (cursor.storedIndex < cursor.stored.size()) {
+        if (++cursor.storedIndex < cursor.stored.size())
+            return true;
+        if (readStored(cursor, store))
+            return true;
+        return cursor.iter != cursor.end;
+    }
+    return ++cursor.iter != cursor.end;
+}
+
+typedef std::pair<qint64, int> HeapEntry;   // clock, cursor
+typedef std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry> > Heap;
+
+void putVarint(QByteArray &out, quint64 v)
+{
+    while (v >= 0x80) {
+        out.append((char)((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.append((char)v);
+}
+
+void putSigned(QByteArray &out, qint64 v)
+{
+    putVarint(out, ((quint64)v << 1) ^ (quint64)(v >> 63));
+}
+
+void putString(QByteArray &out, const QString &s)
+{
+    QByteArray utf8 = s.toUtf8();
+    putVarint(out, utf8.size());
+    out.append(utf8);
+}
+
+QString csvField(const QString &s)
+{
+    if (!s.contains(',') && !s.contains('"') && !s.contains('\n'))
+        return s;
+    QString quoted(s);
+    quoted.replace("\"", "\"\"");
+    return "\"" + quoted + "\"";
+}
+
+// Buffers one block of rows for the columnar format
+class ColumnarWriter {
+public:
+    ColumnarWriter(QFile &_file, int _properties) :
+        file(_file), properties(_properties), columns(_properties), newNameCount(0), rows(0), lastClock(0) {}
+
+    static const int blockRows = 4096;
+
+    void add(const QString &name, const Sample &sample, const QStringList &props) {
+        QHash<QString, int>::const_iterator found = ids.constFind(name);
+        int id;
+        if (found == ids.constEnd()) {
+            id = ids.size();
+            ids.insert(name, id);
+            putString(newNames, name);
+            ++newNameCount;
+            lastValues.append(QVector<qint64>(properties, 0));
+        } else
+            id = found.value();
+
+        putSigned(clocks, sample.clock() - lastClock);
+        lastClock = sample.clock();
+        putVarint(objects, id);
+        QVector<qint64> &last = lastValues[id];
+        for (int i=0; i<properties; ++i) {
+            qint64 v = sample.data(props.at(i));
+            putSigned(columns[i], v - last[i]);
+            last[i] = v;
+        }
+        if (++rows == blockRows)
+            flush();
+    }
+
+    // write any buffered rows and the end marker
+    void finish() {
+        if (rows > 0)
+            flush();
+        QByteArray end;
+        putVarint(end, 0);
+        file.write(end);
+    }
+
+    void flush() {
+        QByteArray block;
+        putVarint(block, rows);
+        putVarint(block, newNameCount);
+        block.append(newNames);
+        putVarint(block, clocks.size());
+        block.append(clocks);
+        putVarint(block, objects.size());
+        block.append(objects);
+        for (int i=0; i<properties; ++i) {
+            putVarint(block, columns[i].size());
+            block.append(columns[i]);
+            columns[i].clear();
+        }
+        file.write(block);
+
+        rows = 0;
+        newNameCount = 0;
+        newNames.clear();
+        clocks.clear();
+        objects.clear();
+    }
+
+private:
+    QFile &file;
+    int properties;
+    QVector<QByteArray> columns;
+    QByteArray clocks;
+    QByteArray objects;
+    QByteArray newNames;
+    int newNameCount;
+    int rows;
+    qint64 lastClock;
+    QHash<QString, int> ids;
+    QList<QVector<qint64> > lastValues;
+};
+
+}
+
+HistoryExport::HistoryExport(QObject *parent, const QString &fileName, Format _format, const QString &_qmfClass,
+                             const QStringList &_properties, const ObjectListModel::Samples &_samples,
+                             SegmentStore *_store, const QStringList &_storedNames) :
+    QThread(parent),
+    path(fileName),
+    format(_format),
+    qmfClass(_qmfClass),
+    properties(_properties),
+    samples(_samples),
+    store(_store),
+    storedNames(_storedNames),
+    cancelled(false),
+    ok(false),
+    written(0)
+{
+}
+
+void HistoryExport::run()
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+
+    // one cursor per object, merged by the time each sample arrived.
+    // The stored samples are counted roughly, the newest of them are also in memory
+    std::vector<Cursor> cursors;
+    Heap heap;
+    quint64 total = 0;
+    QStringList names = samples.keys();
+    QSet<QString> inStore;
+    if (store) {
+        inStore = storedNames.toSet();
+        QStringList::const_iterator iName = storedNames.constBegin();
+        while (iName != storedNames.constEnd()) {
+            if (!samples.contains(*iName))
+                names.append(*iName);
+            ++iName;
+        }
+    }
+    const ObjectListModel::SampleList none;
+    qint64 nowMSecs = QDateTime::currentMSecsSinceEpoch();
+    QStringList::const_iterator iName = names.constBegin();
+    while (iName != names.constEnd() && !cancelled) {
+        ObjectListModel::const_iterSamples found = samples.constFind(*iName);
+        const ObjectListModel::SampleList &memory = found != samples.constEnd() ? found.value() : none;
+        Cursor cursor;
+        cursor.name = *iName;
+        cursor.storedIndex = 0;
+        cursor.nextMSecs = 0;
+        cursor.cutoffMSecs = memory.isEmpty() ? nowMSecs + 1 : memory.first().dateTime().toMSecsSinceEpoch();
+        cursor.iter = memory.constBegin();
+        cursor.end = memory.constEnd();
+        total += memory.size();
+        if (inStore.contains(*iName)) {
+            cursor.nextMSecs = store->firstSeen(*iName);
+            if (cursor.nextMSecs > 0)
+                readStored(cursor, store);
+            total += qMax(0, store->count(*iName) - memory.size());
+        }
+        if (cursor.storedIndex < cursor.stored.size() || cursor.iter != cursor.end) {
+            heap.push(HeapEntry(cursor.sample().clock(), cursors.size()));
+            cursors.push_back(cursor);
+        }
+        ++iName;
+    }
+
+    QTextStream csv(&file);
+    ColumnarWriter columnar(file, properties.size());
+    if (format == formatCsv) {
+        csv << "time,clock_ns,class,name";
+        for (int i=0; i<properties.size(); ++i)
+            csv << "," << csvField(properties.at(i));
+        csv << "\n";
+    } else {
+        QByteArray header("XVH1");
+        putString(header, qmfClass);
+        putVarint(header, properties.size());
+        for (int i=0; i<properties.size(); ++i)
+            putString(header, properties.at(i));
+        if (!heap.empty()) {
+            const Sample &first = cursors[heap.top().second].sample();
+            putSigned(header, first.dateTime().toMSecsSinceEpoch());
+            putSigned(header, first.clock());
+        } else {
+            putSigned(header, 0);
+            putSigned(header, 0);
+        }
+        file.write(header);
+    }
+
+    int lastPercent = -1;
+    QString cls = csvField(qmfClass);
+    while (!heap.empty() && !cancelled) {
+        int index = heap.top().second;
+        Cursor &cursor = cursors[index];
+        heap.pop();
+
+        const Sample &sample = cursor.sample();
+        if (format == formatCsv) {
+            csv << sample.dateTime().toString("yyyy-MM-ddThh:mm:ss.zzz") << "," << sample.clock()
+                << "," << cls << "," << csvField(cursor.name);
+            for (int i=0; i<properties.size(); ++i)
+                csv << "," << sample.data(properties.at(i));
+            csv << "\n";
+        } else {
+            columnar.add(cursor.name, sample, properties);
+        }
+
+        if (advance(cursor, store))
+            heap.push(HeapEntry(cursor.sample().clock(), index));
+
+        int percent = (int)(qMin(++written, total) * 100 / total);
+        if (percent != lastPercent) {
+            lastPercent = percent;
+            emit progress(percent);
+        }
+    }
+
+    if (format == formatCsv)
+        csv.flush();
+    else if (!cancelled)
+        columnar.finish();
+    ok = !cancelled && file.error() == QFile::NoError;
+    file.close();
+    if (!ok)
+        file.remove();
+}
@@ -0,0 +1,85 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef HISTORYEXPORT_H
+#define HISTORYEXPORT_H
+
+#include <QThread>
+#include <QStringList>
+#include "object-model.h"
+#include "segment-store.h"
+
+// Writes the sample history of a set of objects to a file in a background thread.
+// The samples of all the objects are merged into time order as they are written,
+// so nothing beyond one block of output is held in memory. With an on-disk
+// store, the history older than the samples in memory is read from the store
+// a few minutes at a time as the merge reaches it.
+//
+// Two formats are supported:
+//  - CSV: time, clock_ns, class, name and one column per property
+//  - columnar: a compact binary format. All integers are LEB128 varints,
+//    signed ones zigzag encoded. Strings are a varint length and UTF-8 bytes.
+//      header: "XVH1", class, property count, property names,
+//              wall clock msecs and monotonic nsecs of the first sample
+//      blocks: row count, count of new object names, the new names,
+//              then each column as a byte length and its values:
+//                clock   - delta from the previous row
+//                object  - index into the names seen so far
+//                per property - delta from the object's previous value
+//      end:    a block with 0 rows
+class HistoryExport : public QThread
+{
+    Q_OBJECT
+public:
+    enum Format {
+        formatCsv,
+        formatColumnar
+    };
+
+    // samples is a shallow copy of the model's history, safe to read from the thread.
+    // store, if set, supplies the older samples of storedNames. It must outlive the export
+    HistoryExport(QObject *parent, const QString &fileName, Format format, const QString &qmfClass,
+                  const QStringList &properties, const ObjectListModel::Samples &samples,
+                  SegmentStore *store = 0, const QStringList &storedNames = QStringList());
+
+    void cancel() { cancelled = true; }
+    bool succeeded() const { return ok; }
+    QString fileName() const { return path; }
+    quint64 rows() const { return written; }
+
+signals:
+    void progress(int percent);
+
+protected:
+    void run();
+
+private:
+    QString path;
+    Format format;
+    QString qmfClass;
+    QStringList properties;
+    ObjectListModel::Samples samples;
+    SegmentStore *store;
+    QStringList storedNames;
+    volatile bool cancelled;
+    bool ok;
+    quint64 written;
+};
+
+#endif // HISTORYEXPORT_H
@@ -0,0 +1,137 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "leaderboard.h"
+
+Leaderboard::Leaderboard(QObject *parent) :
+    QObject(parent),
+    boards()
+{
+}
+
+Leaderboard::~Leaderboard()
+{
+    qDeleteAll(boards);
+}
+
+int Leaderboard::addMetric(const QString &title, const QString &qmfClass, ObjectListModel *model,
+                           const QString &property, bool rate)
+{
+    Board *board = new Board;
+    board->title = title;
+    board->qmfClass = qmfClass;
+    board->model = model;
+    board->property = property;
+    board->rate = rate;
+    boards.append(board);
+
+    // several boards can share a model. Only connect once
+    bool connected = false;
+    for (int i=0; i<boards.size() - 1; ++i)
+        if (boards.at(i)->model == model)
+            connected = true;
+
+    if (!connected) {
+        connect(model, SIGNAL(sampleAdded(QString,Sample)), this, SLOT(sampleAdded(QString,Sample)));
+        connect(model, SIGNAL(objectRemoved(QString)), this, SLOT(objectRemoved(QString)));
+        connect(model, SIGNAL(objectsCleared()), this, SLOT(objectsCleared()));
+    }
+    return boards.size() - 1;
+}
+
+QList<Leaderboard::Entry> Leaderboard::top(int metric, int count) const
+{
+    QList<Entry> entries;
+    const Ranking &ranking = boards.at(metric)->ranking;
+
+    Ranking::const_reverse_iterator iter = ranking.rbegin();
+    while (iter != ranking.rend() && entries.size() < count) {
+        entries.append(Entry(iter->second, iter->first));
+        ++iter;
+    }
+    return entries;
+}
+
+// SLOT triggered when a model adds a sample for an object
+void Leaderboard::sampleAdded(const QString &name, const Sample &sample)
+{
+    const ObjectListModel *model = (const ObjectListModel *)sender();
+    QList<Board *>::const_iterator iter = boards.constBegin();
+    while (iter != boards.constEnd()) {
+        Board *board = *iter;
+        ++iter;
+        if (board->model != model)
+            continue;
+
+        if (board->rate)
+            update(board, name, sample.rate(board->property).value(model->getRateWindow()));
+        else
+            update(board, name, (qreal)sample.data(board->property));
+    }
+    emit changed();
+}
+
+void Leaderboard::objectRemoved(const QString &name)
+{
+    const ObjectListModel *model = (const ObjectListModel *)sender();
+    QList<Board *>::const_iterator iter = boards.constBegin();
+    while (iter != boards.constEnd()) {
+        if ((*iter)->model == model)
+            remove(*iter, name);
+        ++iter;
+    }
+    emit changed();
+}
+
+void Leaderboard::objectsCleared()
+{
+    const ObjectListModel *model = (const ObjectListModel *)sender();
+    QList<Board *>::const_iterator iter = boards.constBegin();
+    while (iter != boards.constEnd()) {
+        if ((*iter)->model == model) {
+            (*iter)->ranking.clear();
+            (*iter)->current.clear();
+        }
+        ++iter;
+    }
+    emit changed();
+}
+
+void Leaderboard::update(Board *board, const QString &name, qreal value)
+{
+    QHash<QString, qreal>::iterator iter = board->current.find(name);
+    if (iter != board->current.end()) {
+        if (iter.value() == value)
+            return;
+        board->ranking.erase(std::make_pair(iter.value(), name));
+        iter.value() = value;
+    } else
+        board->current.insert(name, value);
+
+    board->ranking.insert(std::make_pair(value, name));
+}
+
+void Leaderboard::remove(Board *board, const QString &name)
+{
+    QHash<QString, qreal>::iterator iter = board->current.find(name);
+    if (iter != board->current.end()) {
+        board->ranking.erase(std::make_pair(iter.value(), name));
+        board->current.erase(iter);
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <set>
+#include "object-model.h"
+
+// Keeps a running ranking of objects for a set of metrics.
+// The rankings are updated as each sample is added to a model, so
+// reading the top N objects never has to sort the whole model.
+class Leaderboard : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Leaderboard(QObject *parent = 0);
+    ~Leaderboard();
+
+    // rank the objects in model by property, or by the rate of change of property
+    int addMetric(const QString &title, const QString &qmfClass, ObjectListModel *model,
+                  const QString &property, bool rate);
+
+    typedef QPair<QString, qreal> Entry;  // object name, value
+    QList<Entry> top(int metric, int count) const;
+
+    int metricCount() const { return boards.size(); }
+    QString title(int metric) const { return boards.at(metric)->title; }
+    QString qmfClass(int metric) const { return boards.at(metric)->qmfClass; }
+    ObjectListModel *model(int metric) const { return boards.at(metric)->model; }
+    bool isRate(int metric) const { return boards.at(metric)->rate; }
+
+signals:
+    void changed();
+
+private slots:
+    void sampleAdded(const QString &name, const Sample &sample);
+    void objectRemoved(const QString &name);
+    void objectsCleared();
+
+private:
+    typedef std::set<std::pair<qreal, QString> > Ranking;
+
+    struct Board {
+        QString title;
+        QString qmfClass;
+        ObjectListModel *model;
+        QString property;
+        bool rate;
+
+        // ordered by value. Updating an object's value is O(log n)
+        // and the largest values are at the end
+        Ranking ranking;
+        QHash<QString, qreal> current;
+    };
+    QList<Board *> boards;
+
+    void update(Board *board, const QString &name, qreal value);
+    void remove(Board *board, const QString &name);
+};
+
+#endif // LEADERBOARD_H
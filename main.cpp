@@ -24,8 +24,9 @@ int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
     XView w;
-    w.show();
     w.init(argc, argv);
+    if (!w.isHeadless())
+        w.show();
 
     return a.exec();
 }
@@ -0,0 +1,408 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "metrics-exporter.h"
+#include <QFile>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <stdio.h>
+
+MetricsExporter::MetricsExporter(QObject *parent) :
+    QObject(parent),
+    changed(true),
+    fileTimer(),
+    server(0),
+    queueExchanges(),
+    bindingsStale(false)
+{
+    connect(&fileTimer, SIGNAL(timeout()), this, SLOT(writeFile()));
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    QList<Source *>::const_iterator iter = sources.constBegin();
+    while (iter != sources.constEnd()) {
+        qDeleteAll((*iter)->families);
+        delete *iter;
+        ++iter;
+    }
+}
+
+void MetricsExporter::addModel(const QString &qmfClass, ObjectListModel *model, const QStringList &properties)
+{
+    Source *source = new Source;
+    source->qmfClass = qmfClass;
+    source->model = model;
+
+    QStringList::const_iterator iter = properties.constBegin();
+    while (iter != properties.constEnd()) {
+        QByteArray name = metricName(qmfClass, *iter);
+        bool counter = model->isCounter(*iter);
+
+        Family *family = new Family;
+        family->property = *iter;
+        family->rate = false;
+        family->name = counter ? name + "_total" : name;
+        family->header = "# TYPE " + name + (counter ? " counter\n" : " gauge\n")
+                + "# HELP " + name + " " + qmfClass.toUtf8() + " " + (*iter).toUtf8() + "\n";
+        source->families.append(family);
+
+        // counters also get the rate the gui shows for them
+        if (counter) {
+            family = new Family;
+            family->property = *iter;
+            family->rate = true;
+            family->name = name + "_per_second";
+            family->header = "# TYPE " + family->name + " gauge\n"
+                    + "# HELP " + family->name + " " + qmfClass.toUtf8() + " " + (*iter).toUtf8()
+                    + " per second, averaged over one minute\n";
+            source->families.append(family);
+        }
+        ++iter;
+    }
+    sources.append(source);
+
+    connect(model, SIGNAL(sampleAdded(QString,Sample)), this, SLOT(sampleAdded(QString,Sample)));
+    connect(model, SIGNAL(objectRemoved(QString)), this, SLOT(objectRemoved(QString)));
+    connect(model, SIGNAL(objectsCleared()), this, SLOT(objectsCleared()));
+
+    // queues are labelled with the exchanges they are bound to
+    if (qmfClass == "binding") {
+        connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(bindingsChanged()));
+        connect(model, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(bindingsChanged()));
+        connect(model, SIGNAL(modelReset()), this, SLOT(bindingsChanged()));
+        bindingsStale = true;
+    }
+}
+
+QStringList MetricsExporter::classes() const
+{
+    QStringList list;
+    QList<Source *>::const_iterator iter = sources.constBegin();
+    while (iter != sources.constEnd()) {
+        list.append((*iter)->qmfClass);
+        ++iter;
+    }
+    return list;
+}
+
+void MetricsExporter::setFile(const QString &name, int interval)
+{
+    fileName = name;
+    fileTimer.start(interval);
+}
+
+bool MetricsExporter::listen(quint16 port)
+{
+    if (!server) {
+        server = new QTcpServer(this);
+        connect(server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+    }
+    return server->listen(QHostAddress::LocalHost, port);
+}
+
+MetricsExporter::Source *MetricsExporter::sourceFor(QObject *model)
+{
+    QList<Source *>::const_iterator iter = sources.constBegin();
+    while (iter != sources.constEnd()) {
+        if ((*iter)->model == model)
+            return *iter;
+        ++iter;
+    }
+    return 0;
+}
+
+// SLOT triggered when a model receives a sample.
+// The line is formatted when the document is next needed, so an
+// object sampled several times between scrapes is only formatted once
+void MetricsExporter::sampleAdded(const QString &name, const Sample &)
+{
+    Source *source = sourceFor(sender());
+    if (source) {
+        source->dirty.insert(name);
+        changed = true;
+    }
+}
+
+// SLOT triggered when an object is no longer on the broker
+void MetricsExporter::objectRemoved(const QString &name)
+{
+    Source *source = sourceFor(sender());
+    if (!source)
+        return;
+    source->dirty.remove(name);
+    QList<Family *>::const_iterator iter = source->families.constBegin();
+    while (iter != source->families.constEnd()) {
+        (*iter)->lines.remove(name);
+        ++iter;
+    }
+    changed = true;
+}
+
+// SLOT triggered when a model drops all of its objects
+void MetricsExporter::objectsCleared()
+{
+    Source *source = sourceFor(sender());
+    if (!source)
+        return;
+    source->dirty.clear();
+    QList<Family *>::const_iterator iter = source->families.constBegin();
+    while (iter != source->families.constEnd()) {
+        (*iter)->lines.clear();
+        ++iter;
+    }
+    changed = true;
+}
+
+// SLOT triggered when a binding is added to or removed from the bindings model
+void MetricsExporter::bindingsChanged()
+{
+    bindingsStale = true;
+}
+
+// Map each queue to the exchanges it is bound to
+void MetricsExporter::indexBindings()
+{
+    bindingsStale = false;
+    queueExchanges.clear();
+    QList<Source *>::const_iterator iSource = sources.constBegin();
+    while (iSource != sources.constEnd()) {
+        if ((*iSource)->qmfClass == "binding") {
+            ObjectListModel *model = (*iSource)->model;
+            int rows = model->rowCount();
+            for (int row=0; row<rows; ++row) {
+                const qpid::types::Variant::Map& props(model->qmfData(row).getProperties());
+                qpid::types::Variant::Map::const_iterator queue = props.find("queueRef");
+                qpid::types::Variant::Map::const_iterator exchange = props.find("exchangeRef");
+                if (queue == props.end() || exchange == props.end())
+                    continue;
+                QString queueName = refName(queue->second);
+                QString exchangeName = refName(exchange->second);
+                // the default exchange has an empty name
+                if (queueName.isEmpty() || exchangeName.isEmpty())
+                    continue;
+                QString &exchanges = queueExchanges[queueName];
+                if (!exchanges.split(',').contains(exchangeName))
+                    exchanges += exchanges.isEmpty() ? exchangeName : "," + exchangeName;
+            }
+        }
+        ++iSource;
+    }
+}
+
+// Format the lines of the objects that changed and reassemble the document.
+// A queue's exchanges label is refreshed with the queue's next sample
+void MetricsExporter::flush()
+{
+    if (!changed)
+        return;
+    if (bindingsStale)
+        indexBindings();
+
+    int size = 0;
+    QList<Source *>::const_iterator iSource = sources.constBegin();
+    while (iSource != sources.constEnd()) {
+        Source *source = *iSource;
+        const ObjectListModel::Samples &samples = source->model->samples();
+
+        QSet<QString>::const_iterator iDirty = source->dirty.constBegin();
+        while (iDirty != source->dirty.constEnd()) {
+            int row = source->model->findRow(*iDirty);
+            ObjectListModel::const_iterSamples iSamples = samples.constFind(*iDirty);
+            if (row >= 0 && iSamples != samples.constEnd() && !iSamples.value().isEmpty()) {
+                const Sample &sample = iSamples.value().last();
+                QByteArray objectLabels = labels(source->qmfClass, *iDirty, source->model->qmfData(row));
+
+                QList<Family *>::const_iterator iFamily = source->families.constBegin();
+                while (iFamily != source->families.constEnd()) {
+                    Family *family = *iFamily;
+                    QByteArray value;
+                    if (!family->rate)
+                        value = QByteArray::number(sample.data(family->property));
+                    else if (sample.hasRate(family->property))
+                        value = QByteArray::number(sample.rate(family->property).avg1m, 'g', 10);
+
+                    if (value.isEmpty())
+                        family->lines.remove(*iDirty);
+                    else
+                        family->lines.insert(*iDirty, family->name + objectLabels + " " + value + "\n");
+                    ++iFamily;
+                }
+            }
+            ++iDirty;
+        }
+        source->dirty.clear();
+
+        QList<Family *>::const_iterator iFamily = source->families.constBegin();
+        while (iFamily != source->families.constEnd()) {
+            size += (*iFamily)->header.size() + (*iFamily)->lines.size() * ((*iFamily)->name.size() + 64);
+            ++iFamily;
+        }
+        ++iSource;
+    }
+
+    cached.clear();
+    cached.reserve(size + 8);
+    iSource = sources.constBegin();
+    while (iSource != sources.constEnd()) {
+        QList<Family *>::const_iterator iFamily = (*iSource)->families.constBegin();
+        while (iFamily != (*iSource)->families.constEnd()) {
+            cached.append((*iFamily)->header);
+            QHash<QString, QByteArray>::const_iterator iLine = (*iFamily)->lines.constBegin();
+            while (iLine != (*iFamily)->lines.constEnd()) {
+                cached.append(iLine.value());
+                ++iLine;
+            }
+            ++iFamily;
+        }
+        ++iSource;
+    }
+    cached.append("# EOF\n");
+    changed = false;
+}
+
+QByteArray MetricsExporter::document()
+{
+    flush();
+    return cached;
+}
+
+// SLOT triggered by the file timer.
+// Write to a temporary file and rename it so a collector never reads a partial file
+void MetricsExporter::writeFile()
+{
+    if (!changed || fileName.isEmpty())
+        return;
+
+    QString tempName = fileName + ".tmp";
+    QFile file(tempName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+    QByteArray text = document();
+    bool written = file.write(text) == text.size();
+    file.close();
+    if (!written || ::rename(QFile::encodeName(tempName).constData(), QFile::encodeName(fileName).constData()) != 0)
+        QFile::remove(tempName);
+}
+
+// SLOT triggered when a scraper connects
+void MetricsExporter::newConnection()
+{
+    while (server->hasPendingConnections()) {
+        QTcpSocket *socket = server->nextPendingConnection();
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    }
+}
+
+// SLOT triggered when request data arrives.
+// Any GET is answered with the document once the request headers are complete
+void MetricsExporter::readRequest()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    if (!socket)
+        return;
+    if (!socket->peek(socket->bytesAvailable()).contains("\r\n\r\n"))
+        return;
+
+    QByteArray request = socket->readAll();
+    QByteArray response;
+    if (request.startsWith("GET ")) {
+        QByteArray body = document();
+        response = "HTTP/1.0 200 OK\r\n"
+                   "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                   "Content-Length: " + QByteArray::number(body.size()) + "\r\n\r\n" + body;
+    } else {
+        response = "HTTP/1.0 405 Method Not Allowed\r\nContent-Length: 0\r\n\r\n";
+    }
+    socket->write(response);
+    socket->disconnectFromHost();
+}
+
+// qmf property names are camel case, metric names are snake case
+QByteArray MetricsExporter::metricName(const QString &qmfClass, const QString &property)
+{
+    QByteArray name = "qpid_" + qmfClass.toLatin1() + "_";
+    QByteArray prop = property.toLatin1();
+    for (int i=0; i<prop.size(); ++i) {
+        char c = prop.at(i);
+        if (c >= 'A' && c <= 'Z') {
+            name.append('_');
+            name.append(c - 'A' + 'a');
+        } else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))
+            name.append(c);
+        else
+            name.append('_');
+    }
+    return name;
+}
+
+// The object's name plus the objects it refers to, so a series can be
+// joined to its queue, exchange, session or connection. Queues also get
+// the exchanges they are bound to
+QByteArray MetricsExporter::labels(const QString &qmfClass, const QString &name, const qmf::Data &object) const
+{
+    static const char *refs[][2] = {
+        {"queueRef", "queue"},
+        {"exchangeRef", "exchange"},
+        {"sessionRef", "session"},
+        {"connectionRef", "connection"}
+    };
+
+    QByteArray text = "{name=\"" + escape(name) + "\"";
+    const qpid::types::Variant::Map& props(object.getProperties());
+    for (unsigned i=0; i<sizeof(refs) / sizeof(refs[0]); ++i) {
+        qpid::types::Variant::Map::const_iterator iter = props.find(refs[i][0]);
+        if (iter == props.end())
+            continue;
+        QString ref = refName(iter->second);
+        if (!ref.isEmpty())
+            text += QByteArray(",") + refs[i][1] + "=\"" + escape(ref) + "\"";
+    }
+    if (qmfClass == "queue") {
+        QHash<QString, QString>::const_iterator iExchanges = queueExchanges.constFind(name);
+        if (iExchanges != queueExchanges.constEnd())
+            text += ",exchanges=\"" + escape(iExchanges.value()) + "\"";
+    }
+    text += "}";
+    return text;
+}
+
+// The name of the object a reference points at.
+// _object_name is org.apache.qpid.broker:<class>:<name>, and the name
+// itself can hold colons, as a connection's address does
+QString MetricsExporter::refName(const qpid::types::Variant &ref)
+{
+    if (ref.getType() != qpid::types::VAR_MAP)
+        return QString();
+    const qpid::types::Variant::Map& map(ref.asMap());
+    qpid::types::Variant::Map::const_iterator iter = map.find("_object_name");
+    if (iter == map.end())
+        return QString();
+    return QString(iter->second.asString().c_str()).section(':', 2, -1);
+}
+
+QByteArray MetricsExporter::escape(const QString &value)
+{
+    QByteArray text = value.toUtf8();
+    text.replace('\\', "\\\\");
+    text.replace('"', "\\\"");
+    text.replace('\n', "\\n");
+    return text;
+}
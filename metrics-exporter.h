@@ -0,0 +1,104 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QByteArray>
+#include <QTimer>
+#include <QTcpServer>
+#include "object-model.h"
+
+// Publishes the latest sample of every object as OpenMetrics text,
+// either by rewriting a file for a textfile collector or by answering
+// scrapes on a loopback port.
+// Only the objects that received a sample since the last export are
+// formatted again. Every other series reuses its cached line.
+class MetricsExporter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetricsExporter(QObject *parent = 0);
+    ~MetricsExporter();
+
+    // export these sampled properties of each object in model
+    void addModel(const QString &qmfClass, ObjectListModel *model, const QStringList &properties);
+    QStringList classes() const;
+
+    // rewrite fileName every interval msecs when something changed
+    void setFile(const QString &fileName, int interval = 5000);
+    // serve scrapes on 127.0.0.1:port
+    bool listen(quint16 port);
+
+    // the current OpenMetrics document
+    QByteArray document();
+
+private slots:
+    void sampleAdded(const QString &name, const Sample &sample);
+    void objectRemoved(const QString &name);
+    void objectsCleared();
+    void bindingsChanged();
+    void writeFile();
+    void newConnection();
+    void readRequest();
+
+private:
+    // one metric family, with the cached line of each object
+    struct Family {
+        QByteArray header;      // the # TYPE and # HELP lines
+        QByteArray name;        // metric name of the samples
+        QString property;
+        bool rate;
+        QHash<QString, QByteArray> lines;
+    };
+
+    struct Source {
+        QString qmfClass;
+        ObjectListModel *model;
+        QList<Family *> families;
+        QSet<QString> dirty;    // objects with a new sample
+    };
+    QList<Source *> sources;
+
+    QByteArray cached;          // the last assembled document
+    bool changed;               // cached is out of date
+    QString fileName;
+    QTimer fileTimer;
+    QTcpServer *server;
+
+    // the exchanges each queue is bound to, comma separated, for the
+    // queues' labels. Rebuilt from the bindings model when it gains or
+    // loses a binding
+    QHash<QString, QString> queueExchanges;
+    bool bindingsStale;
+
+    Source *sourceFor(QObject *model);
+    void flush();
+    static QByteArray metricName(const QString &qmfClass, const QString &property);
+    void indexBindings();
+    QByteArray labels(const QString &qmfClass, const QString &name, const qmf::Data &object) const;
+    static QString refName(const qpid::types::Variant &ref);
+    static QByteArray escape(const QString &value);
+};
+
+#endif // METRICSEXPORTER_H
@@ -18,18 +18,41 @@
  */
 
 #include "object-model.h"
+#include "diagnostics.h"
+#include "segment-store.h"
+#include <QBrush>
 #include <iostream>
+#include <algorithm>
 
 using std::cout;
 using std::endl;
 
+namespace {
+
+// Orders samples by their monotonic clock
+struct SampleClock {
+    bool operator()(const Sample& sample, qint64 clock) const { return sample.clock() < clock; }
+    bool operator()(qint64 clock, const Sample& sample) const { return clock < sample.clock(); }
+};
+
+}
+
 ObjectListModel::ObjectListModel(QObject* parent, std::string unique, const QStringList& columnList) :
         QAbstractTableModel(parent), uniqueProperty(unique),
         sampleProperties(),
-        invalid()
+        invalid(),
+        rateWindow(SampleRate::windowInstant),
+        segmentStore(0)
 {
     sampleLife = 600;
     sampleProperties = columnList;
+    revisionCount = 0;
+
+    QStringList::const_iterator iter = columnList.constBegin();
+    while (iter != columnList.constEnd()) {
+        sampleKeys.push_back((*iter).toStdString());
+        ++iter;
+    }
 }
 
 void ObjectListModel::addObject(const qmf::Data& object, uint correlator)
@@ -37,6 +60,11 @@ void ObjectListModel::addObject(const qmf::Data& object, uint correlator)
     if (!object.isValid())
         return;
 
+    // derived properties are added to the object so everything downstream
+    // treats them like the broker's own, including as the unique property
+    if (!derivedList.isEmpty())
+        derive(object);
+
     // get the uniqueu property for this object
     const qpid::types::Variant& name = object.getProperty(uniqueProperty);
 
@@ -44,15 +72,28 @@ void ObjectListModel::addObject(const qmf::Data& object, uint correlator)
     addSample(object, name);
 
     // see if the object exists in the list
-    for (int idx=0; idx<dataList.size(); idx++) {
+    QString key(name.asString().c_str());
+    int idx = rowHash.value(key, -1);
+    if (idx >= 0) {
         qmf::Data existing = dataList.at(idx);
-        if (name.isEqualTo(existing.getProperty(uniqueProperty))) {
 
-            qpid::types::Variant::Map map = qpid::types::Variant::Map(object.getProperties());
-            map["correlator"] = correlator;
-            existing.overwriteProperties(map);
+        // objects loaded from a snapshot are replaced by the live object
+        if (existing.getProperty("correlator").asUint32() == snapshotCorrelator) {
+            qmf::Data o = qmf::Data(object);
+            o.setProperty("correlator", qpid::types::Variant(correlator));
+            dataList[idx] = o;
+            valueList[idx] = rowValues(object);
+            ++revisionCount;
+            emit dataChanged(index(idx, 0), index(idx, columnCount() - 1));
             return;
         }
+
+        qpid::types::Variant::Map map = qpid::types::Variant::Map(object.getProperties());
+        map["correlator"] = correlator;
+        existing.overwriteProperties(map);
+        valueList[idx] = rowValues(object);
+        ++revisionCount;
+        return;
     }
 
     qmf::Data o = qmf::Data(object);
@@ -63,13 +104,54 @@ void ObjectListModel::addObject(const qmf::Data& object, uint correlator)
     int last = dataList.size();
     beginInsertRows(QModelIndex(), last, last);
     dataList.append(o);
+    valueList.append(rowValues(object));
+    rowHash[key] = last;
+    ++revisionCount;
     endInsertRows();
-    //dataHash[name.asString()] = o;
+}
+
+// Show the objects from a saved snapshot until the first live query arrives.
+// They are marked with a correlator no query uses, so the first full
+// refresh of this class replaces or removes them
+int ObjectListModel::loadObjects(const QList<qmf::Data>& objects)
+{
+    if (!dataList.isEmpty() || objects.isEmpty())
+        return 0;
+
+    beginInsertRows(QModelIndex(), 0, objects.size() - 1);
+    QList<qmf::Data>::const_iterator iter = objects.constBegin();
+    while (iter != objects.constEnd()) {
+        qmf::Data o(*iter);
+        o.setProperty("correlator", qpid::types::Variant(snapshotCorrelator));
+        QString key(o.getProperty(uniqueProperty).asString().c_str());
+        rowHash[key] = dataList.size();
+        dataList.append(o);
+        valueList.append(rowValues(o));
+        ++iter;
+    }
+    ++revisionCount;
+    endInsertRows();
+    return objects.size();
+}
+
+// The numeric values of the sampled properties, in column order
+ObjectListModel::RowValues ObjectListModel::rowValues(const qmf::Data& object) const
+{
+    const qpid::types::Variant::Map& props(object.getProperties());
+    RowValues values(sampleKeys.size());
+    for (int col=0; col<(int)sampleKeys.size(); ++col) {
+        qpid::types::Variant::Map::const_iterator iter = props.find(sampleKeys[col]);
+        values[col] = (iter != props.end()) ? (qreal)Sample::number(iter->second) : 0.0;
+    }
+    return values;
 }
 
 void ObjectListModel::refresh(uint correlator)
 {
+    Diagnostics::Timer timer("gui: model refresh");
+
     // remove any old queues that were not added/updated with this correlator
+    bool removed = false;
     for (int idx=0; idx<dataList.size(); idx++) {
         uint corr = dataList.at(idx).getProperty("correlator").asUint32();
         if (corr != correlator) {
@@ -78,11 +160,22 @@ void ObjectListModel::refresh(uint correlator)
             if (samplesData.contains(name)) {
                 samplesData.remove(name);
             }
+            firstSeenHash.remove(name);
+            rateEngine.remove(name);
+            flaggedNames.remove(name);
+            emit objectRemoved(name);
             beginRemoveRows( QModelIndex(), idx, idx );
-            dataList.removeAt(idx--);
+            dataList.removeAt(idx);
+            valueList.removeAt(idx--);
             endRemoveRows();
+            removed = true;
         }
     }
+    // the rows after the removed ones have moved up
+    if (removed) {
+        rebuildRowHash();
+        ++revisionCount;
+    }
 
     // force a refresh of the display
     QModelIndex topLeft = index(0, 0);
@@ -101,7 +194,21 @@ void ObjectListModel::clear()
 {
     beginRemoveRows(QModelIndex(), 0, dataList.count() - 1);
     dataList.clear();
+    valueList.clear();
+    rowHash.clear();
+    flaggedNames.clear();
+    ++revisionCount;
     endRemoveRows();
+    emit objectsCleared();
+}
+
+void ObjectListModel::rebuildRowHash()
+{
+    rowHash.clear();
+    for (int idx=0; idx<dataList.size(); idx++) {
+        QString name(dataList.at(idx).getProperty(uniqueProperty).asString().c_str());
+        rowHash[name] = idx;
+    }
 }
 
 
@@ -135,12 +242,10 @@ const std::string &ObjectListModel::unique(bool useKey)
 
 const qmf::Data& ObjectListModel::find(const qmf::Data& existing)
 {
-    const qpid::types::Variant& name = existing.getProperty(uniqueProperty);
-    for (int idx=0; idx<dataList.size(); idx++) {
-        if (name.isEqualTo(dataList.at(idx).getProperty(uniqueProperty))) {
-            return dataList.at(idx);
-        }
-    }
+    QString name(existing.getProperty(uniqueProperty).asString().c_str());
+    int idx = rowHash.value(name, -1);
+    if (idx >= 0)
+        return dataList.at(idx);
     return invalid;
 }
 
@@ -155,6 +260,12 @@ QVariant ObjectListModel::data(const QModelIndex &index, int role) const
         return QVariant(dataList.at(index.row()));
     }
 
+    if (role == Qt::BackgroundRole) {
+        if (!flaggedNames.isEmpty() && flaggedNames.contains(uniqueName(index.row())))
+            return QBrush(QColor(255, 200, 200));
+        return QVariant();
+    }
+
     if (role != Qt::DisplayRole && role != Qt::ToolTipRole)
         return QVariant();
 
@@ -178,32 +289,30 @@ QVariant ObjectListModel::data(const QModelIndex &index, int role) const
     }
     // for the value columns (shown in the related table) return the numeric value
     int col = index.column() - 1;
-    std::string prop = sampleProperties.at(col).toStdString();
-    iter = props.find(prop);
-    if (iter != props.end()) {
-        if (role == Qt::DisplayRole)
-            return QVariant((qreal)(*iter).second.asInt64());
-        else {
-            return QString("%1 %2").arg(prop.c_str()).arg((*iter).second.asInt64());
-        }
-    }
-    return QString();
+    qreal val = valueList.at(index.row()).at(col);
+    if (role == Qt::DisplayRole)
+        return QVariant(val);
+    return QString("%1 %2").arg(sampleProperties.at(col)).arg((qint64)val);
 }
 
 std::string ObjectListModel::fieldValue(int row, const std::string& field)
 {
     const qmf::Data& object= dataList.at(row);
     qpid::types::Variant value = object.getProperty(field);
-    if ((field == "queueRef") ||
-        (field == "exchangeRef") ||
-        (field == "sessionRef") ||
-        (field == "connectionRef") ||
-        (field == "vhostRef")) {
-        return value.asMap()["_object_name"].asString();
+    // references such as queueRef or linkRef are maps holding the object name
+    if (value.getType() == qpid::types::VAR_MAP) {
+        const qpid::types::Variant::Map& ref(value.asMap());
+        qpid::types::Variant::Map::const_iterator iter = ref.find("_object_name");
+        return iter != ref.end() ? iter->second.asString() : std::string();
     }
     return value.asString();
 }
 
+QString ObjectListModel::uniqueName(int row) const
+{
+    return QString(dataList.at(row).getProperty(uniqueProperty).asString().c_str());
+}
+
 const qmf::Data& ObjectListModel::qmfData(int row)
 {
     return dataList.at(row);
@@ -262,34 +371,128 @@ std::ostream& operator<<(std::ostream& out, const qmf::Data& object)
 void ObjectListModel::addSample(const qmf::Data& object, const qpid::types::Variant& name)
 {
     QString key = QString(name.asString().c_str());
-    samplesData[key].append(Sample(object, sampleProperties));
+    Sample sample(object, sampleProperties);
+    SampleList& sampleList = samplesData[key];
+    if (!firstSeenHash.contains(key))
+        firstSeenHash.insert(key, sample.dateTime().toMSecsSinceEpoch());
+
+    // the rates must be set before the sample is shared with the list
+    rateEngine.update(key, object, sample, sampleList.isEmpty() ? 0 : &sampleList.last(), sampleProperties);
+    sampleList.append(sample);
+    emit sampleAdded(key, sample);
+}
+
+void ObjectListModel::addDerived(const QString& name, const Expression& expression)
+{
+    QList<Derived>::const_iterator iter = derivedList.constBegin();
+    while (iter != derivedList.constEnd()) {
+        if ((*iter).name == name.toStdString())
+            return;
+        ++iter;
+    }
+
+    Derived derived;
+    derived.name = name.toStdString();
+    derived.expression = expression;
+    derivedList.append(derived);
+
+    QStringList inputs = expression.properties();
+    for (int i=0; i<inputs.size(); ++i) {
+        if (!derivedInputs.contains(inputs.at(i)))
+            derivedInputs.append(inputs.at(i));
+    }
+}
+
+// Evaluate the derived properties from the object's own
+void ObjectListModel::derive(const qmf::Data& object)
+{
+    qmf::Data o(object);
+    Sample inputs(o, derivedInputs);
+    QList<Derived>::const_iterator iter = derivedList.constBegin();
+    while (iter != derivedList.constEnd()) {
+        qint64 value = qRound64((*iter).expression.evaluate(inputs));
+        o.setProperty((*iter).name, qpid::types::Variant((int64_t)value));
+        ++iter;
+    }
 }
 
 void ObjectListModel::expireSamples()
 {
-    QDateTime tnow(QDateTime::currentDateTime());
-    int secs;
+    qint64 oldest = Sample::now() - (qint64)sampleLife * 1000000000;
 
     QStringList keys = samplesData.keys();
     QStringList::const_iterator iter = keys.constBegin();
     while (iter != keys.constEnd()) {
         SampleList &sampleList(samplesData[*iter]);
 
-        iterSampleList iterList = sampleList.begin();
-        while (iterList != sampleList.end()) {
-            secs = (*iterList).dateTime().secsTo(tnow);
-            if (secs > sampleLife) {
-                // erase increments iterList
-                iterList = sampleList.erase(iterList);
-            } else
-                break;
-        }
+        int expired = sampleIndex(sampleList, oldest);
+        if (expired > 0)
+            sampleList.erase(sampleList.begin(), sampleList.begin() + expired);
 
         ++iter;
     }
 }
 
+int ObjectListModel::sampleIndex(const SampleList& list, qint64 clock)
+{
+    return std::lower_bound(list.constBegin(), list.constEnd(), clock, SampleClock()) - list.constBegin();
+}
+
+bool ObjectListModel::sampleAt(const QString& name, qint64 msecs, Sample& sample) const
+{
+    const_iterSamples iter = samplesData.constFind(name);
+    if (iter != samplesData.constEnd()) {
+        const SampleList& list = iter.value();
+        const_iterSampleList found = std::upper_bound(list.constBegin(), list.constEnd(), Sample::clockAt(msecs), SampleClock());
+        if (found != list.constBegin()) {
+            sample = *(found - 1);
+            return true;
+        }
+    }
+    // older than anything in memory
+    return segmentStore && segmentStore->sampleAt(name, msecs, sample);
+}
+
+qint64 ObjectListModel::firstSeen(const QString& name) const
+{
+    qint64 seen = firstSeenHash.value(name, 0);
+    if (segmentStore) {
+        QHash<QString, qint64>::const_iterator found = storedFirstSeen.constFind(name);
+        if (found == storedFirstSeen.constEnd())
+            found = storedFirstSeen.insert(name, segmentStore->firstSeen(name));
+        if (found.value() > 0 && (seen == 0 || found.value() < seen))
+            seen = found.value();
+    }
+    return seen;
+}
+
+void ObjectListModel::setFlagged(const QString& name, bool flag)
+{
+    if (flag == flaggedNames.contains(name))
+        return;
+    if (flag)
+        flaggedNames.insert(name);
+    else
+        flaggedNames.remove(name);
+
+    int row = findRow(name);
+    if (row >= 0)
+        emit dataChanged(index(row, 0), index(row, columnCount() - 1));
+}
+
 void ObjectListModel::clearSamples()
 {
     samplesData.clear();
+    firstSeenHash.clear();
+    rateEngine.clear();
+    emit objectsCleared();
+}
+
+// The current rate of change of an object's property, using the selected window
+qreal ObjectListModel::rate(const QString& name, const QString& property) const
+{
+    const_iterSamples iter = samplesData.constFind(name);
+    if (iter == samplesData.constEnd() || iter.value().isEmpty())
+        return 0.0;
+    return iter.value().last().rate(property).value(rateWindow);
 }
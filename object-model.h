@@ -21,13 +21,20 @@
 
 #include <QAbstractListModel>
 #include <QModelIndex>
-#include <QLinkedList>
+#include <QList>
 #include <QHash>
+#include <QSet>
+#include <QVector>
 #include <QDateTime>
 #include <qmf/Data.h>
 #include <sstream>
 #include <string>
+#include <vector>
 #include "sample.h"
+#include "rate-engine.h"
+#include "expression.h"
+
+class SegmentStore;
 
 class ObjectListModel : public QAbstractTableModel {
     Q_OBJECT
@@ -42,26 +49,70 @@ public:
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
 
     std::string fieldValue(int row, const std::string& field);
+    QString uniqueName(int row) const;
     const qmf::Data& qmfData(int row);
     const qmf::Data& find(const qmf::Data& existing);
+    int findRow(const QString& name) const { return rowHash.value(name, -1); }
+
+    // the numeric value of a sampled property column (column 0 is the name)
+    qreal value(int row, int column) const { return valueList.at(row).at(column - 1); }
+    // changes whenever any row is added, removed or updated
+    quint64 revision() const { return revisionCount; }
     void refresh(uint correlator);
+    // add objects from a saved snapshot when the model is empty
+    int loadObjects(const QList<qmf::Data>& objects);
     void expireSamples();
     void setDuration(int duration) { sampleLife = duration; }
     void clearSamples();
     void setKey(const std::string &altKey);
     const std::string &unique(bool useKey);
 
-    // list of values for an individual object
-    typedef QLinkedList<Sample> SampleList;
-    typedef QLinkedList<Sample>::const_iterator const_iterSampleList;
+    // list of values for an individual object, oldest first.
+    // Random access so a time can be found with a binary search
+    typedef QList<Sample> SampleList;
+    typedef QList<Sample>::const_iterator const_iterSampleList;
 
     // hash of lists keyed by object name
     typedef QHash<QString, SampleList> Samples;
     typedef QHash<QString, SampleList>::const_iterator const_iterSamples;
 
-    const Samples& samples() { return samplesData; }
+    const Samples& samples() const { return samplesData; }
+    const QStringList& sampled() const { return sampleProperties; }
+
+    // index of the first sample in the list taken at or after a monotonic clock time
+    static int sampleIndex(const SampleList& list, qint64 clock);
+    // the latest sample of an object at or before a wall clock time,
+    // from memory or the on-disk store
+    bool sampleAt(const QString& name, qint64 msecs, Sample& sample) const;
+    // wall clock time of the oldest sample seen for an object, 0 if none
+    qint64 firstSeen(const QString& name) const;
+
+    // rates are precomputed as each sample is added
+    qreal rate(const QString& name, const QString& property) const;
+    void setRateWindow(SampleRate::Window window) { rateWindow = window; }
+    SampleRate::Window getRateWindow() const { return rateWindow; }
     const qmf::Data& getSelected(const QModelIndex &index);
 
+    // optional on-disk history, for times older than the samples kept in memory
+    void setStore(SegmentStore *_store) { segmentStore = _store; storedFirstSeen.clear(); }
+    SegmentStore *store() const { return segmentStore; }
+
+    // a property computed from the others as each object arrives.
+    // Its value is rounded like the broker's counters
+    void addDerived(const QString& name, const Expression& expression);
+
+    // counters only go up, so a drop is a reset. Gauges go up and down
+    void setCounter(const QString& property, bool counter) { rateEngine.setCounter(property, counter); }
+    bool isCounter(const QString& property) const { return rateEngine.isCounter(property); }
+
+    // objects marked as behaving unusually are drawn highlighted
+    void setFlagged(const QString& name, bool flag);
+    bool flagged(const QString& name) const { return flaggedNames.contains(name); }
+
+    // the objects picked in the dialog for the section's chart to compare
+    void setCompared(const QStringList& names) { comparedNames = names; }
+    const QStringList& compared() const { return comparedNames; }
+
 public slots:
     void addObject(const qmf::Data&, uint);
     void connectionChanged(bool isConnected);
@@ -70,9 +121,15 @@ public slots:
 
 signals:
     void objectSelected(const qmf::Data&);
+    // a new sample has been added to the history of an object
+    void sampleAdded(const QString& name, const Sample& sample);
+    // the object is no longer on the broker
+    void objectRemoved(const QString& name);
+    // all objects and/or samples were discarded
+    void objectsCleared();
 
 protected:
-    typedef QLinkedList<Sample>::iterator iterSampleList;
+    typedef QList<Sample>::iterator iterSampleList;
     typedef QHash<QString, SampleList>::iterator iterSamples;
 
     // the data for the objects in the display listbox
@@ -84,17 +141,45 @@ protected:
     std::string uniqueProperty;
 
     int sampleLife;
+    static const uint snapshotCorrelator = 0xffffffff;
     void addSample(const qmf::Data& object, const qpid::types::Variant& name);
 
 private:
     // historical data for rates and charting
     Samples samplesData;
+    // when each object was first sampled in this run, and in the store
+    QHash<QString, qint64> firstSeenHash;
+    mutable QHash<QString, qint64> storedFirstSeen;
 
     // list of properties to save for charting
     QStringList sampleProperties;
     qmf::Data invalid;
 
-    QHash<std::string, qmf::Data&> dataHash;
+    // the sampled property values of each row, kept up to date on ingest
+    typedef QVector<qreal> RowValues;
+    QList<RowValues> valueList;
+    std::vector<std::string> sampleKeys;
+    quint64 revisionCount;
+    RowValues rowValues(const qmf::Data& object) const;
+
+    RateEngine rateEngine;
+    SampleRate::Window rateWindow;
+    SegmentStore *segmentStore;
+
+    // unique property -> row in dataList
+    QHash<QString, int> rowHash;
+    void rebuildRowHash();
+
+    QSet<QString> flaggedNames;
+    QStringList comparedNames;
+
+    struct Derived {
+        std::string name;
+        Expression expression;
+    };
+    QList<Derived> derivedList;
+    QStringList derivedInputs;  // the properties the derived ones read
+    void derive(const qmf::Data& object);
 };
 
 std::ostream& operator<<(std::ostream& out, const qmf::Data& queue);
@@ -25,7 +25,8 @@ PropertyDelegate::PropertyDelegate(QObject *parent, const QStringList &cols) :
     mmList(),
     colorList(),
     nameList(),
-    allColumns(cols)
+    allColumns(cols),
+    columnInfo()
 {
 }
 
@@ -41,9 +42,7 @@ void PropertyDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opti
     }
 
     // draw a value column as a colored bar
-    QString colName = allColumns.at(column - 1);
-
-    int infoIndex = nameList.indexOf(colName);
+    int infoIndex = columnInfo.value(column, -1);
     if (infoIndex >= 0) {
         MinMax mm = mmList.at(infoIndex);
         QColor color = colorList.at(infoIndex);
@@ -59,11 +58,7 @@ void PropertyDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opti
         if (percent > 0.0 && width < 1)
             width = 1;
 
-        //qDebug("property: colName:%s  val:%f  percent: %f max:%f  rect.width():%i  width:%i", colName.toStdString().c_str(), (float)val, percent, (float)mm.max, option.rect.width(), width);
-
         painter->fillRect(option.rect.x(), option.rect.y() + option.rect.height() / 2 - 8, width, 16, QBrush(color));
-    } else {
-        qDebug("*** can't find column %s", colName.toStdString().c_str());
     }
 }
 
@@ -72,4 +67,9 @@ void PropertyDelegate::setColumnInfo(const QList<QColor> & c, const QList<MinMax
     mmList = mm;
     colorList = c;
     nameList = nl;
+
+    // look up each column's info once here rather than on every paint
+    columnInfo.fill(-1, allColumns.size() + 1);
+    for (int col=0; col<allColumns.size(); ++col)
+        columnInfo[col + 1] = nameList.indexOf(allColumns.at(col));
 }
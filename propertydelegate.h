@@ -21,6 +21,7 @@
 #define PROPERTYDELEGATE_H
 
 #include <QItemDelegate>
+#include <QVector>
 #include "sample.h" // for MinMax
 
 class PropertyDelegate : public QItemDelegate
@@ -43,6 +44,7 @@ private:
     QList<QColor> colorList;
     QStringList   nameList;
     QStringList allColumns;
+    QVector<int> columnInfo; // view column -> index into the info lists, or -1
 };
 
 #endif // PROPERTYDELEGATE_H
@@ -18,6 +18,7 @@
  */
 
 #include "qmf-thread.h"
+#include "diagnostics.h"
 #include <qpid/messaging/exceptions.h>
 #include <qmf/Query.h>
 #include <qmf/engine/Value.h>
@@ -175,6 +176,7 @@ void QmfThread::run()
                         std::stringstream line;
                         line << "Operational (URL: " << command.url << ")";
                         emit connectionStatusChanged(line.str().c_str());
+                        emit connectedTo(QString(command.url.c_str()));
                     } catch(qpid::messaging::MessagingException& ex) {
                         std::stringstream line;
                         line << "QMF Session Failed: " << ex.what();
@@ -198,7 +200,7 @@ void QmfThread::run()
 // with the args used to make the call and an object that
 // will be notified when the call completes.
 void QmfThread::queryBroker(const std::string& qmf_class,
-                            QObject* object)
+                            QObject* object, const std::string& package)
 {
     // don't try to send a query if we are connecting or disconnecting
     if ((command_queue.size() > 0) || (!connected) || (disconnecting))
@@ -206,10 +208,11 @@ void QmfThread::queryBroker(const std::string& qmf_class,
 
     QMutexLocker locker(&lock);
 
-    query_queue.push_back(Query(object, true));
+    query_queue.push_back(Query(object, true, QString("query %1").arg(qmf_class.c_str())));
+    query_queue.back().sent = Diagnostics::now();
     qmf::Agent agent = sess.getConnectedBrokerAgent();
     query_queue.back().correlator = agent.queryAsync(
-                qmf::Query(qmf::QUERY_OBJECT, qmf_class, "org.apache.qpid.broker"));
+                qmf::Query(qmf::QUERY_OBJECT, qmf_class, package));
 
     cond.wakeOne();
 }
@@ -222,7 +225,8 @@ void QmfThread::queryObject(const qmf::DataAddr& dataAddr, QObject* object)
 
     QMutexLocker locker(&lock);
 
-    query_queue.push_back(Query(object, false));
+    query_queue.push_back(Query(object, false, "query object"));
+    query_queue.back().sent = Diagnostics::now();
     qmf::Agent agent = sess.getConnectedBrokerAgent();
     query_queue.back().correlator = agent.queryAsync(
                 qmf::Query(dataAddr));
@@ -242,8 +246,17 @@ void QmfThread::dispatchQueryResults(qmf::ConsoleEvent& event)
 
     for (query_queue_t::iterator iter=query_queue.begin();
                             iter != query_queue.end(); iter++) {
-        const Query& qq(*iter);
+        Query& qq(*iter);
         if (qq.correlator == correlator) {
+            // time from sending the query to the first and the last batch
+            qint64 elapsed = Diagnostics::now() - qq.sent;
+            if (!qq.answered) {
+                Diagnostics::record(qq.timing + ": first batch", elapsed);
+                qq.answered = true;
+            }
+            if (event.isFinal())
+                Diagnostics::record(qq.timing + ": final batch", elapsed);
+
             emit receivedResponse(qq.object, event, qq.all);
 
             if (event.isFinal())
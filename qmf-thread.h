@@ -46,7 +46,10 @@ public:
     QmfThread(QObject* parent);
     void cancel();
 
-    void queryBroker(const std::string& qmf_class, QObject* object);
+    // query every object of a class. The store and journal classes
+    // are in the store's package rather than the broker's
+    void queryBroker(const std::string& qmf_class, QObject* object,
+                     const std::string& package = "org.apache.qpid.broker");
     void queryObject(const qmf::DataAddr& dataAddr, QObject* object);
 
 public slots:
@@ -58,6 +61,7 @@ public slots:
 signals:
     void connectionStatusChanged(const QString&);
     void isConnected(bool);
+    void connectedTo(const QString& url);
     void addExchange(const qmf::Data&, uint);
     void doneAddingExchanges(uint);
 
@@ -95,9 +99,12 @@ private:
         uint32_t correlator;
         QObject* object;
         bool all;
+        QString timing;     // name the round trip is recorded under
+        qint64 sent;        // when the query was sent, see Diagnostics::now()
+        bool answered;      // the first batch has arrived
 
-        Query(QObject* _o, bool _b) : correlator(0),
-            object(_o), all(_b) {}
+        Query(QObject* _o, bool _b, const QString& _t) : correlator(0),
+            object(_o), all(_b), timing(_t), sent(0), answered(false) {}
     };
     typedef std::deque<Query> query_queue_t;
     query_queue_t query_queue;
@@ -0,0 +1,95 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "rate-engine.h"
+#include <math.h>
+
+// time constants of the moving averages, in seconds
+static const double tauOneMinute = 60.0;
+static const double tauFiveMinutes = 300.0;
+
+RateEngine::RateEngine() :
+    gauges(),
+    createTimes()
+{
+    gauges << "msgDepth" << "byteDepth" << "unackedMessages";
+}
+
+void RateEngine::setCounter(const QString& property, bool counter)
+{
+    if (counter)
+        gauges.removeAll(property);
+    else if (!gauges.contains(property))
+        gauges.append(property);
+}
+
+void RateEngine::update(const QString& name, const qmf::Data& object, Sample& sample,
+                        const Sample* previous, const QStringList& properties)
+{
+    // a new create time means the object was deleted and recreated
+    bool recreated = false;
+    const qpid::types::Variant::Map& props = object.getProperties();
+    qpid::types::Variant::Map::const_iterator ts = props.find("_create_ts");
+    if (ts != props.end()) {
+        qint64 created = ts->second.asInt64();
+        QHash<QString, qint64>::iterator iter = createTimes.find(name);
+        if (iter == createTimes.end())
+            createTimes.insert(name, created);
+        else if (iter.value() != created) {
+            recreated = true;
+            iter.value() = created;
+        }
+    }
+
+    double elapsed = previous ? Sample::elapsed(*previous, sample) : 0.0;
+    double alpha1 = 1.0 - exp(-elapsed / tauOneMinute);
+    double alpha5 = 1.0 - exp(-elapsed / tauFiveMinutes);
+
+    QStringList::const_iterator iter = properties.constBegin();
+    while (iter != properties.constEnd()) {
+        const QString& property = *iter;
+        ++iter;
+
+        SampleRate rate;
+        if (elapsed <= 0.0) {
+            // first sample, or no time has passed. Carry the previous rates forward
+            if (previous && previous->hasRate(property))
+                sample.setRate(property, previous->rate(property));
+            continue;
+        }
+
+        qint64 delta = sample.data(property) - previous->data(property);
+        bool counter = isCounter(property);
+        if (recreated || (counter && delta < 0)) {
+            // the counter restarted from zero sometime since the last sample
+            delta = counter ? sample.data(property) : 0;
+        }
+        rate.instant = delta / elapsed;
+
+        if (previous->hasRate(property) && !recreated) {
+            SampleRate last = previous->rate(property);
+            rate.avg1m = last.avg1m + alpha1 * (rate.instant - last.avg1m);
+            rate.avg5m = last.avg5m + alpha5 * (rate.instant - last.avg5m);
+        } else {
+            rate.avg1m = rate.instant;
+            rate.avg5m = rate.instant;
+        }
+        sample.setRate(property, rate);
+    }
+}
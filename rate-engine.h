@@ -0,0 +1,58 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef RATEENGINE_H
+#define RATEENGINE_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <qmf/Data.h>
+#include "sample.h"
+
+// Computes the rates of change for each new sample from the previous sample
+// of the same object. The instantaneous rate and the 1 and 5 minute moving
+// averages are stored in the sample, so the table, charts and alerts all
+// read the same precomputed values.
+//
+// Counters that go backwards, and objects that were deleted and recreated
+// with the same name, are treated as counter resets rather than as a huge
+// negative (or wrapped) rate.
+class RateEngine
+{
+public:
+    RateEngine();
+
+    void update(const QString& name, const qmf::Data& object, Sample& sample,
+                const Sample* previous, const QStringList& properties);
+    void remove(const QString& name) { createTimes.remove(name); }
+    void clear() { createTimes.clear(); }
+
+    // false for properties that go up and down, like queue depth.
+    // The broker's depths are gauges until told otherwise
+    bool isCounter(const QString& property) const { return !gauges.contains(property); }
+    void setCounter(const QString& property, bool counter);
+
+private:
+    QStringList gauges;
+    // the broker's creation time of each object, to notice recreated objects
+    QHash<QString, qint64> createTimes;
+};
+
+#endif // RATEENGINE_H
@@ -20,23 +20,111 @@
 #include "related-model.h"
 #include <QColor>
 #include <QBrush>
+#include <algorithm>
 
 RelatedFilterProxyModel::RelatedFilterProxyModel(QObject *parent) :
-    QSortFilterProxyModel(parent)
+    QAbstractProxyModel(parent),
+    viewMSecs(0),
+    accepted(),
+    proxyRows(),
+    scanned(0),
+    wanted(batchSize),
+    mmCache(),
+    mmRevision(0),
+    mmValid(false)
 {
 }
 
+void RelatedFilterProxyModel::setSourceModel(QAbstractItemModel *model)
+{
+    if (sourceModel())
+        disconnect(sourceModel(), 0, this, 0);
+
+    QAbstractProxyModel::setSourceModel(model);
+
+    connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)),
+            this, SLOT(sourceRowsInserted(QModelIndex,int,int)));
+    connect(model, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+            this, SLOT(sourceRowsAboutToBeRemoved(QModelIndex,int,int)));
+    connect(model, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+            this, SLOT(sourceRowsRemoved(QModelIndex,int,int)));
+    connect(model, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+            this, SLOT(sourceDataChanged(QModelIndex,QModelIndex)));
+    connect(model, SIGNAL(modelReset()), this, SLOT(sourceReset()));
+    connect(model, SIGNAL(layoutChanged()), this, SLOT(sourceReset()));
+
+    invalidate();
+}
+
 void RelatedFilterProxyModel::setRelatedData( const std::string& f, const std::string& v)
 {
     field = f;
     value = v;
+    mmValid = false;
+}
+
+void RelatedFilterProxyModel::setViewTime(qint64 msecs)
+{
+    if (msecs == viewMSecs)
+        return;
+    viewMSecs = msecs;
+    invalidate();
+}
+
+// Forget the filtered rows. They are found again as the views ask for them
+void RelatedFilterProxyModel::invalidate()
+{
+    beginResetModel();
+    accepted.clear();
+    proxyRows.clear();
+    scanned = 0;
+    wanted = batchSize;
+    mmValid = false;
+    append(scan(), false);
+    endResetModel();
+}
+
+// Filter more source rows until the views have as many rows as they want.
+// Returns the newly accepted source rows. The caller adds them with append()
+QVector<int> RelatedFilterProxyModel::scan()
+{
+    QVector<int> found;
+    int sourceRows = sourceModel() ? sourceModel()->rowCount() : 0;
+    while (scanned < sourceRows && accepted.size() + found.size() < wanted) {
+        if (filterAcceptsRow(scanned))
+            found.append(scanned);
+        ++scanned;
+    }
+    return found;
+}
+
+// Add newly accepted rows to the end, telling the views if asked
+void RelatedFilterProxyModel::append(const QVector<int>& found, bool notify)
+{
+    if (found.isEmpty())
+        return;
+
+    int first = accepted.size();
+    if (notify)
+        beginInsertRows(QModelIndex(), first, first + found.size() - 1);
+    for (int i=0; i<found.size(); ++i) {
+        proxyRows.insert(found.at(i), first + i);
+        accepted.append(found.at(i));
+    }
+    if (notify)
+        endInsertRows();
+}
+
+void RelatedFilterProxyModel::rebuildProxyRows()
+{
+    proxyRows.clear();
+    for (int row=0; row<accepted.size(); ++row)
+        proxyRows.insert(accepted.at(row), row);
 }
 
-// Override the virtual filterAcceptsRow to provide custom filtering
 // Asks the model to get the value of this->field and compares
 // it to this->value.
-bool RelatedFilterProxyModel::filterAcceptsRow(int sourceRow,
-         const QModelIndex &) const
+bool RelatedFilterProxyModel::filterAcceptsRow(int sourceRow) const
 {
     if (field == "")
         return false;
@@ -44,21 +132,207 @@ bool RelatedFilterProxyModel::filterAcceptsRow(int sourceRow,
     ObjectListModel *model = (ObjectListModel *)sourceModel();
 
     QString row_val(model->fieldValue(sourceRow, field).c_str());
+    bool accept;
     if (value == "")
-        return row_val.isEmpty();
-    bool accept = row_val.endsWith(value.c_str());
+        accept = row_val.isEmpty();
+    else
+        accept = row_val.endsWith(value.c_str());
+
+    // objects that first showed up after the time being viewed didn't exist yet
+    if (accept && viewMSecs) {
+        qint64 seen = model->firstSeen(model->uniqueName(sourceRow));
+        if (seen > viewMSecs)
+            accept = false;
+    }
     return accept;
 }
 
+QModelIndex RelatedFilterProxyModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (parent.isValid() || row < 0 || row >= accepted.size() || column < 0 || column >= columnCount())
+        return QModelIndex();
+    return createIndex(row, column);
+}
+
+QModelIndex RelatedFilterProxyModel::parent(const QModelIndex &) const
+{
+    return QModelIndex();
+}
+
+int RelatedFilterProxyModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return accepted.size();
+}
+
+int RelatedFilterProxyModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !sourceModel())
+        return 0;
+    return sourceModel()->columnCount();
+}
+
+QModelIndex RelatedFilterProxyModel::mapToSource(const QModelIndex &proxyIndex) const
+{
+    if (!proxyIndex.isValid() || proxyIndex.row() >= accepted.size())
+        return QModelIndex();
+    return sourceModel()->index(accepted.at(proxyIndex.row()), proxyIndex.column());
+}
+
+QModelIndex RelatedFilterProxyModel::mapFromSource(const QModelIndex &sourceIndex) const
+{
+    if (!sourceIndex.isValid())
+        return QModelIndex();
+    int row = proxyRows.value(sourceIndex.row(), -1);
+    if (row < 0)
+        return QModelIndex();
+    return createIndex(row, sourceIndex.column());
+}
+
+bool RelatedFilterProxyModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !sourceModel())
+        return false;
+    return scanned < sourceModel()->rowCount();
+}
+
+void RelatedFilterProxyModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid())
+        return;
+
+    wanted = accepted.size() + batchSize;
+    append(scan(), true);
+}
+
+// SLOT triggered when objects are added to the source model
+void RelatedFilterProxyModel::sourceRowsInserted(const QModelIndex &, int first, int last)
+{
+    if (first < scanned) {
+        // rows were inserted in the middle. Start over
+        invalidate();
+        return;
+    }
+    Q_UNUSED(last);
+
+    // if we had looked at every row and still want more, look at the new ones
+    append(scan(), true);
+}
+
+// SLOT triggered when objects are about to be removed from the source model
+void RelatedFilterProxyModel::sourceRowsAboutToBeRemoved(const QModelIndex &, int first, int last)
+{
+    for (int sourceRow=last; sourceRow>=first; --sourceRow) {
+        int row = proxyRows.value(sourceRow, -1);
+        if (row >= 0) {
+            beginRemoveRows(QModelIndex(), row, row);
+            accepted.remove(row);
+            rebuildProxyRows();
+            endRemoveRows();
+        }
+    }
+}
+
+// SLOT triggered when objects have been removed from the source model
+// The source rows after the removed ones have moved up
+void RelatedFilterProxyModel::sourceRowsRemoved(const QModelIndex &, int first, int last)
+{
+    int count = last - first + 1;
+    for (int row=0; row<accepted.size(); ++row)
+        if (accepted.at(row) > last)
+            accepted[row] -= count;
+
+    if (scanned > last)
+        scanned -= count;
+    else if (scanned > first)
+        scanned = first;
+
+    rebuildProxyRows();
+    mmValid = false;
+}
+
+// SLOT triggered when the source model's values change
+void RelatedFilterProxyModel::sourceDataChanged(const QModelIndex &, const QModelIndex &)
+{
+    if (accepted.isEmpty())
+        return;
+    emit dataChanged(index(0, 0), index(accepted.size() - 1, columnCount() - 1));
+}
+
+void RelatedFilterProxyModel::sourceReset()
+{
+    invalidate();
+}
+
+// compares source rows by one column's value
+class SourceRowLessThan
+{
+public:
+    SourceRowLessThan(const ObjectListModel *m, int c, Qt::SortOrder o) : model(m), column(c), order(o) { }
+    bool operator()(int left, int right) const {
+        return order == Qt::AscendingOrder ? less(left, right) : less(right, left);
+    }
+private:
+    bool less(int left, int right) const {
+        if (column == 0)
+            return model->index(left, 0).data().toString() < model->index(right, 0).data().toString();
+        return model->value(left, column) < model->value(right, column);
+    }
+    const ObjectListModel *model;
+    int column;
+    Qt::SortOrder order;
+};
+
+void RelatedFilterProxyModel::sort(int column, Qt::SortOrder order)
+{
+    if (!sourceModel() || column < 0 || column >= columnCount())
+        return;
+
+    emit layoutAboutToBeChanged();
+
+    // remember which source rows the views' persistent indexes point at
+    QModelIndexList oldList = persistentIndexList();
+    QList<int> oldSource;
+    for (int i=0; i<oldList.size(); ++i)
+        oldSource.append(accepted.value(oldList.at(i).row(), -1));
+
+    wanted = sourceModel()->rowCount();
+    append(scan(), false);
+    std::stable_sort(accepted.begin(), accepted.end(),
+                     SourceRowLessThan((const ObjectListModel *)sourceModel(), column, order));
+    rebuildProxyRows();
+
+    QModelIndexList newList;
+    for (int i=0; i<oldList.size(); ++i) {
+        int row = proxyRows.value(oldSource.at(i), -1);
+        newList.append(row < 0 ? QModelIndex() : createIndex(row, oldList.at(i).column()));
+    }
+    changePersistentIndexList(oldList, newList);
+
+    emit layoutChanged();
+}
+
 // Return the min and max for this column
+// This covers the rows that have been fetched so far
 MinMax RelatedFilterProxyModel::minMax(int column)
 {
-    MinMax mm = MinMax();
-    for (int idx=0; idx<rowCount(); idx++) {
-        QModelIndex index = this->mapToSource(this->index(idx, column));
-        qreal val = sourceModel()->data(index).toReal();
-        mm.max = qMax(val, mm.max);
-        mm.min = qMin(val, mm.min);
+    ObjectListModel *model = (ObjectListModel *)sourceModel();
+    if (!mmValid || mmRevision != model->revision()) {
+        int columns = model->columnCount();
+        mmCache.fill(MinMax(), columns);
+        QVector<int>::const_iterator iter = accepted.constBegin();
+        while (iter != accepted.constEnd()) {
+            for (int col=1; col<columns; ++col) {
+                qreal val = model->value(*iter, col);
+                MinMax& mm = mmCache[col];
+                mm.max = qMax(val, mm.max);
+                mm.min = qMin(val, mm.min);
+            }
+            ++iter;
+        }
+        mmRevision = model->revision();
+        mmValid = true;
     }
-    return mm;
+    return mmCache.value(column);
 }
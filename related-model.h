@@ -20,31 +20,78 @@
 #ifndef RELATEDMODEL_H
 #define RELATEDMODEL_H
 
-#include <QSortFilterProxyModel>
+#include <QAbstractProxyModel>
+#include <QVector>
+#include <QHash>
 #include "object-model.h"
 
-class RelatedFilterProxyModel : public QSortFilterProxyModel
+// Filters the main object model down to the objects related to the
+// current object in another section.
+//
+// The filter is applied lazily. Rows are only examined until enough
+// matches have been found to fill the batch the view asked for, and
+// views get more through canFetchMore()/fetchMore() as they scroll.
+// A popup with 100k related objects costs about the same to open as
+// one with 10.
+class RelatedFilterProxyModel : public QAbstractProxyModel
 {
     Q_OBJECT
 public:
     explicit RelatedFilterProxyModel(QObject *parent = 0);
 
+    void setSourceModel(QAbstractItemModel *sourceModel);
     void setRelatedData( const std::string& field, const std::string& value);
     MinMax minMax(int column);
 
-    void clearFilter() { invalidateFilter(); }
+    void clearFilter() { invalidate(); }
+    // only accept objects that had been seen by a past wall clock time, 0 for now
+    void setViewTime(qint64 msecs);
 
-protected:
-    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const;
+    virtual QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
+    virtual QModelIndex parent(const QModelIndex &child) const;
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    virtual int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    virtual QModelIndex mapToSource(const QModelIndex &proxyIndex) const;
+    virtual QModelIndex mapFromSource(const QModelIndex &sourceIndex) const;
+
+    virtual bool canFetchMore(const QModelIndex &parent) const;
+    virtual void fetchMore(const QModelIndex &parent);
 
-signals:
+    // sorting needs all the related rows, so it fetches the rest first
+    virtual void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
 
-public slots:
+    static const int batchSize = 200;
+
+protected:
+    bool filterAcceptsRow(int sourceRow) const;
+
+private slots:
+    void sourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void sourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void sourceRowsRemoved(const QModelIndex &parent, int first, int last);
+    void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void sourceReset();
 
 private:
     std::string field;
     std::string value;
+    qint64 viewMSecs;
+
+    QVector<int> accepted;          // proxy row -> source row
+    QHash<int, int> proxyRows;      // source row -> proxy row
+    int scanned;                    // source rows before this have been filtered
+    int wanted;                     // number of accepted rows the views have asked for
+
+    void invalidate();
+    QVector<int> scan();
+    void append(const QVector<int>& found, bool notify);
+    void rebuildProxyRows();
 
+    // min and max of every column over the accepted rows.
+    // Rebuilt in one pass when the source model or the filter has changed
+    QVector<MinMax> mmCache;
+    quint64 mmRevision;
+    bool mmValid;
 };
 
 #endif // RELATEDMODEL_H
@@ -24,7 +24,8 @@ RelatedHeaderView::RelatedHeaderView(Qt::Orientation orientation, QWidget *paren
     QHeaderView(orientation, parent),
     colorList(),
     nameList(),
-    allColumns()
+    allColumns(),
+    columnInfo()
 {
     moved = false;
 }
@@ -43,10 +44,7 @@ void RelatedHeaderView::paintSection(QPainter *painter, const QRect &rect, int l
     }
     painter->setRenderHint(QPainter::Antialiasing);
 
-    int infoIndex = logicalIndex - 1;
-
-    QString colName = allColumns.at(infoIndex);
-    int nameIndex = nameList.indexOf(colName);
+    int nameIndex = columnInfo.value(logicalIndex, -1);
     if (nameIndex >= 0 && nameIndex < colorList.size()) {
         QColor color(colorList.at(nameIndex));
 
@@ -77,6 +75,11 @@ void RelatedHeaderView::setColumnInfo(const QList<QColor> & c, const QStringList
 {
     colorList = c;
     nameList = n;
+
+    // look up each section's info once here rather than on every paint
+    columnInfo.fill(-1, allColumns.size() + 1);
+    for (int col=0; col<allColumns.size(); ++col)
+        columnInfo[col + 1] = nameList.indexOf(allColumns.at(col));
 }
 
 void RelatedHeaderView::setAllColumns(const QStringList & cols)
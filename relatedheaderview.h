@@ -21,6 +21,7 @@
 #define RELATEDHEADERVIEW_H
 
 #include <QHeaderView>
+#include <QVector>
 #include "sample.h"
 
 class RelatedHeaderView : public QHeaderView
@@ -45,6 +46,7 @@ private:
     QList<QColor> colorList;
     QStringList   nameList;
     QStringList allColumns;
+    QVector<int> columnInfo; // section -> index into the info lists, or -1
     bool moved;
 };
 
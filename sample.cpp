@@ -18,16 +18,69 @@
  */
 
 #include "sample.h"
+#include <QElapsedTimer>
 
 Sample::Sample(const qmf::Data& data, const QStringList& list, QDateTime dt)
 {
 
     d = new SampleData;
     setDateTime(dt);
+    setClock(now());
 
+    // the broker stamps each object with the time its statistics were taken
+    const qpid::types::Variant::Map& props = data.getProperties();
+    qpid::types::Variant::Map::const_iterator ts = props.find("_update_ts");
+    if (ts != props.end())
+        setUpdateTime(ts->second.asInt64());
+    else
+        setUpdateTime(0);
+
+    // a configured property the object doesn't have is left out and reads as 0
     QStringList::const_iterator iter = list.constBegin();
     while (iter != list.constEnd()) {
-        setProperty(*iter, data.getProperty((*iter).toStdString()).asInt64());
+        qpid::types::Variant::Map::const_iterator prop = props.find((*iter).toStdString());
+        if (prop != props.end())
+            setProperty(*iter, number(prop->second));
         ++iter;
     }
 }
+
+qint64 Sample::number(const qpid::types::Variant& value)
+{
+    switch (value.getType()) {
+    case qpid::types::VAR_VOID:
+        return 0;
+    case qpid::types::VAR_BOOL:
+        return value.asBool() ? 1 : 0;
+    case qpid::types::VAR_FLOAT:
+    case qpid::types::VAR_DOUBLE:
+        return qRound64(value.asDouble());
+    default:
+        break;
+    }
+    try {
+        return value.asInt64();
+    } catch (qpid::types::InvalidConversion&) {
+        return 0;
+    }
+}
+
+qint64 Sample::now()
+{
+    static QElapsedTimer timer;
+    if (!timer.isValid())
+        timer.start();
+    return timer.nsecsElapsed();
+}
+
+qint64 Sample::clockAt(qint64 msecs)
+{
+    return now() - (QDateTime::currentMSecsSinceEpoch() - msecs) * 1000000;
+}
+
+double Sample::elapsed(const Sample& earlier, const Sample& later)
+{
+    if (earlier.updateTime() > 0 && later.updateTime() > earlier.updateTime())
+        return (later.updateTime() - earlier.updateTime()) / 1.0e9;
+    return (later.clock() - earlier.clock()) / 1.0e9;
+}
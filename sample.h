@@ -21,6 +21,7 @@
 #define SAMPLE_H
 
 #include <QSharedData>
+#include <QHash>
 #include <QDateTime>
 #include <QVariant>
 #include <QStringList>
@@ -35,31 +36,74 @@ public:
     qreal max;
 };
 
+// The rates of change of one property at the time of a sample
+class SampleRate {
+public:
+    enum Window {
+        windowInstant,
+        windowOneMinute,
+        windowFiveMinutes
+    };
+
+    SampleRate() : instant(0.0), avg1m(0.0), avg5m(0.0) { }
+    qreal value(Window window) const {
+        return window == windowOneMinute ? avg1m : (window == windowFiveMinutes ? avg5m : instant); }
+
+    qreal instant;  // change / second since the previous sample
+    qreal avg1m;    // exponentially weighted moving averages
+    qreal avg5m;
+};
+
 class SampleData : public QSharedData
 {
 public:
     SampleData()  { }
     SampleData(const SampleData& other)
-        : QSharedData(other), dateTime(other.dateTime), data(other.data) { }
+        : QSharedData(other), dateTime(other.dateTime), clock(other.clock),
+          updateTime(other.updateTime), data(other.data), rates(other.rates) { }
     ~SampleData() { }
 
-    QDateTime               dateTime;
+    QDateTime               dateTime;   // wall clock, for display
+    qint64                  clock;      // monotonic nanoseconds, see Sample::now()
+    qint64                  updateTime; // broker's _update_ts in nanoseconds, 0 if unknown
     QHash<QString, qint64>  data;
+    QHash<QString, SampleRate> rates;
 };
 
 class Sample
 {
 public:
-    Sample() { d = new SampleData; }
+    Sample() { d = new SampleData; d->clock = 0; d->updateTime = 0; }
     Sample(const qmf::Data& data, const QStringList& list, QDateTime dt=QDateTime::currentDateTime());
     Sample(const Sample& other) : d (other.d) { }
 
     void setDateTime(const QDateTime & dt) { d->dateTime = dt; }
+    void setClock(qint64 ns) { d->clock = ns; }
+    void setUpdateTime(qint64 ns) { d->updateTime = ns; }
     void setProperty(const QString& key, qint64 value) { d->data.insert(key, value); }
+    void setRate(const QString& key, const SampleRate& rate) { d->rates.insert(key, rate); }
 
     QDateTime dateTime() const { return d->dateTime; }
+    qint64 clock() const { return d->clock; }
+    qint64 updateTime() const { return d->updateTime; }
     qint64 data(const QString& key) const { return d->data.value(key, 0); }
     qint64 data(const std::string& key) const { return data(QString(key.c_str())); }
+    bool hasRate(const QString& key) const { return d->rates.contains(key); }
+    SampleRate rate(const QString& key) const { return d->rates.value(key); }
+
+    // a property value as a number. Booleans are 0 or 1, and values that
+    // aren't numbers are 0
+    static qint64 number(const qpid::types::Variant& value);
+
+    // monotonic nanoseconds since the first sample was taken
+    static qint64 now();
+    // the monotonic clock at a wall clock time in msecs since the epoch
+    static qint64 clockAt(qint64 msecs);
+    // seconds between two samples. Uses the broker's update times when both
+    // samples have them, otherwise the times the samples arrived
+    static double elapsed(const Sample& earlier, const Sample& later);
+    // seconds since this sample arrived
+    double age(qint64 tnow = now()) const { return (tnow - d->clock) / 1.0e9; }
 
 private:
     QSharedDataPointer<SampleData> d;
@@ -0,0 +1,411 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "search-index.h"
+#include <algorithm>
+
+namespace {
+
+// only numbers can be compared, a string or map property would throw
+bool isNumber(const qpid::types::Variant& value)
+{
+    switch (value.getType()) {
+    case qpid::types::VAR_UINT8:
+    case qpid::types::VAR_UINT16:
+    case qpid::types::VAR_UINT32:
+    case qpid::types::VAR_UINT64:
+    case qpid::types::VAR_INT8:
+    case qpid::types::VAR_INT16:
+    case qpid::types::VAR_INT32:
+    case qpid::types::VAR_INT64:
+    case qpid::types::VAR_FLOAT:
+    case qpid::types::VAR_DOUBLE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+}
+
+SearchIndex::SearchIndex(QObject *parent) :
+    QObject(parent),
+    entries(),
+    entryHash(),
+    models(),
+    modelClass(),
+    lastTerms(),
+    lastMatches(),
+    lastValid(false)
+{
+}
+
+void SearchIndex::addModel(const QString &qmfClass, ObjectListModel *model)
+{
+    models[qmfClass] = model;
+    modelClass[model] = qmfClass;
+
+    connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)),
+            this, SLOT(sourceRowsInserted(QModelIndex,int,int)));
+    connect(model, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+            this, SLOT(sourceRowsAboutToBeRemoved(QModelIndex,int,int)));
+
+    for (int row=0; row<model->rowCount(); ++row)
+        addEntry(qmfClass, model, row);
+}
+
+void SearchIndex::sourceRowsInserted(const QModelIndex &, int first, int last)
+{
+    ObjectListModel *model = (ObjectListModel *)sender();
+    QString qmfClass = modelClass.value(model);
+    for (int row=first; row<=last; ++row)
+        addEntry(qmfClass, model, row);
+}
+
+void SearchIndex::sourceRowsAboutToBeRemoved(const QModelIndex &, int first, int last)
+{
+    ObjectListModel *model = (ObjectListModel *)sender();
+    QString qmfClass = modelClass.value(model);
+    for (int row=first; row<=last; ++row)
+        removeEntry(qmfClass, model->uniqueName(row));
+}
+
+void SearchIndex::addEntry(const QString &qmfClass, ObjectListModel *model, int row)
+{
+    Entry entry;
+    entry.qmfClass = qmfClass;
+    entry.model = model;
+    entry.name = model->uniqueName(row);
+    entry.label = model->data(model->index(row, 0)).toString();
+    entry.lower = entry.label.toLower();
+
+    QString k = key(qmfClass, entry.name);
+    if (entryHash.contains(k))
+        return;
+    entryHash[k] = entries.size();
+    entries.append(entry);
+    lastValid = false;
+}
+
+void SearchIndex::removeEntry(const QString &qmfClass, const QString &name)
+{
+    QHash<QString, int>::iterator iter = entryHash.find(key(qmfClass, name));
+    if (iter == entryHash.end())
+        return;
+
+    // move the last entry into the hole
+    int idx = iter.value();
+    entryHash.erase(iter);
+    int lastIdx = entries.size() - 1;
+    if (idx != lastIdx) {
+        entries[idx] = entries.at(lastIdx);
+        entryHash[key(entries.at(idx).qmfClass, entries.at(idx).name)] = idx;
+    }
+    entries.remove(lastIdx);
+    lastValid = false;
+}
+
+// Allow singular and plural class names, and prefixes that only one class
+// starts with. error is set when the prefix fits more than one class
+QString SearchIndex::resolveClass(const QString &token, QString *error) const
+{
+    QString lower = token.toLower();
+    if (lower.isEmpty())
+        return QString();
+
+    QStringList prefixed;
+    QHash<QString, ObjectListModel *>::const_iterator iter = models.constBegin();
+    while (iter != models.constEnd()) {
+        if (iter.key() == lower || iter.key() + "s" == lower)
+            return iter.key();
+        if (iter.key().startsWith(lower))
+            prefixed.append(iter.key());
+        ++iter;
+    }
+    if (prefixed.size() == 1)
+        return prefixed.first();
+    if (prefixed.size() > 1 && error) {
+        prefixed.sort();
+        *error = QString("%1: could be %2").arg(token).arg(prefixed.join(", "));
+    }
+    return QString();
+}
+
+bool SearchIndex::parse(const QString &query, TermList &terms, QString *error) const
+{
+    static QRegExp compareExp("^(?:(\\w+):)?(\\w+)(>=|<=|!=|>|<|=)(-?[0-9.]+)$");
+    static QRegExp classExp("^(\\w+):(.*)$");
+
+    QStringList tokens = query.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+    QStringList::const_iterator iter = tokens.constBegin();
+    while (iter != tokens.constEnd()) {
+        const QString &token = *iter;
+        Term term;
+        term.type = Term::termText;
+        term.number = 0;
+
+        if (compareExp.exactMatch(token)) {
+            term.type = Term::termCompare;
+            if (!compareExp.cap(1).isEmpty()) {
+                term.qmfClass = resolveClass(compareExp.cap(1), error);
+                if (term.qmfClass.isEmpty()) {
+                    if (error && error->isEmpty())
+                        *error = QString("%1: unknown class").arg(compareExp.cap(1));
+                    return false;
+                }
+            }
+            term.field = compareExp.cap(2).toLower();
+            term.op = compareExp.cap(3);
+            bool ok;
+            term.number = compareExp.cap(4).toDouble(&ok);
+            if (!ok)
+                return false;
+        } else if (token.length() > 1 && token.startsWith('/') && token.endsWith('/')) {
+            term.type = Term::termRegex;
+            term.regex = QRegExp(token.mid(1, token.length() - 2), Qt::CaseInsensitive);
+            if (!term.regex.isValid())
+                return false;
+        } else if (classExp.exactMatch(token)) {
+            // a word before a colon that isn't a class is just text
+            QString ambiguous;
+            term.qmfClass = resolveClass(classExp.cap(1), &ambiguous);
+            if (!ambiguous.isEmpty()) {
+                if (error)
+                    *error = ambiguous;
+                return false;
+            }
+            if (term.qmfClass.isEmpty())
+                term.text = token.toLower();
+            else {
+                term.type = classExp.cap(2).isEmpty() ? Term::termClass : Term::termText;
+                term.text = classExp.cap(2).toLower();
+            }
+        } else {
+            term.text = token.toLower();
+        }
+        terms.append(term);
+        ++iter;
+    }
+    return true;
+}
+
+// Find the numeric property that an abbreviated field name refers to
+std::string SearchIndex::resolveField(const Entry &entry, const QString &field) const
+{
+    int row = entry.model->findRow(entry.name);
+    if (row < 0)
+        return std::string();
+
+    const qpid::types::Variant::Map& props(entry.model->qmfData(row).getProperties());
+    qpid::types::Variant::Map::const_iterator iter;
+    std::string partial;
+    for (iter = props.begin(); iter != props.end(); iter++) {
+        if (!isNumber(iter->second))
+            continue;
+        QString prop = QString(iter->first.c_str()).toLower();
+        if (prop == field || prop == "msg" + field)
+            return iter->first;
+        if (partial.empty() && prop.contains(field))
+            partial = iter->first;
+    }
+    return partial;
+}
+
+// Return the score for this entry, or -1 if it doesn't match
+int SearchIndex::match(const Entry &entry, TermList &terms) const
+{
+    int score = 0;
+    TermList::iterator iter = terms.begin();
+    while (iter != terms.end()) {
+        Term &term = *iter;
+        ++iter;
+
+        if (!term.qmfClass.isEmpty() && term.qmfClass != entry.qmfClass)
+            return -1;
+
+        switch (term.type) {
+        case Term::termClass:
+            break;
+
+        case Term::termText: {
+            if (term.text.isEmpty())
+                break;
+            int s = fuzzyScore(term.text, entry.lower);
+            if (s < 0)
+                return -1;
+            score += s;
+            break;
+        }
+
+        case Term::termRegex:
+            if (term.regex.indexIn(entry.label) < 0)
+                return -1;
+            score += 100;
+            break;
+
+        case Term::termCompare: {
+            // The objects of a class share their properties, but optional
+            // ones can be missing, so a field is only kept once it is found
+            std::string field = term.fields.value(entry.qmfClass);
+            if (field.empty()) {
+                field = resolveField(entry, term.field);
+                if (field.empty())
+                    return -1;
+                term.fields[entry.qmfClass] = field;
+            }
+            int row = entry.model->findRow(entry.name);
+            if (row < 0)
+                return -1;
+            const qpid::types::Variant::Map& props(entry.model->qmfData(row).getProperties());
+            qpid::types::Variant::Map::const_iterator prop = props.find(field);
+            if (prop == props.end() || prop->second.getType() == qpid::types::VAR_VOID)
+                return -1;
+            qreal value = (qreal)Sample::number(prop->second);
+            bool ok = false;
+            if (term.op == ">")       ok = value >  term.number;
+            else if (term.op == ">=") ok = value >= term.number;
+            else if (term.op == "<")  ok = value <  term.number;
+            else if (term.op == "<=") ok = value <= term.number;
+            else if (term.op == "=")  ok = value == term.number;
+            else if (term.op == "!=") ok = value != term.number;
+            if (!ok)
+                return -1;
+            break;
+        }
+        }
+    }
+    return score;
+}
+
+// Score a subsequence match of pattern in text. Contiguous runs,
+// matches at the start of words and short names score higher.
+int SearchIndex::fuzzyScore(const QString &pattern, const QString &text)
+{
+    int pos = text.indexOf(pattern);
+    if (pos >= 0) {
+        int score = 1000 - pos - (text.length() - pattern.length());
+        if (pos == 0)
+            score += 500;
+        return score;
+    }
+
+    int score = 0;
+    int run = 0;
+    int next = 0;
+    for (int i=0; i<pattern.length(); ++i) {
+        pos = text.indexOf(pattern.at(i), next);
+        if (pos < 0)
+            return -1;
+        if (pos == next && i > 0) {
+            ++run;
+            score += 5 * run;
+        } else
+            run = 0;
+        if (pos == 0 || QString("._-:/ ").contains(text.at(pos - 1)))
+            score += 10;
+        score -= pos - next;
+        next = pos + 1;
+    }
+    return score - text.length() / 4;
+}
+
+bool SearchIndex::plainQuery(const TermList &terms)
+{
+    TermList::const_iterator iter = terms.constBegin();
+    while (iter != terms.constEnd()) {
+        if ((*iter).type != Term::termText && (*iter).type != Term::termClass)
+            return false;
+        ++iter;
+    }
+    return true;
+}
+
+// Can every object that matches terms be found among the matches of previous?
+// True when each previous term is still there, of the same kind and class,
+// with its text only added to
+bool SearchIndex::narrows(const TermList &terms, const TermList &previous)
+{
+    if (terms.size() < previous.size())
+        return false;
+    for (int i=0; i<previous.size(); ++i) {
+        const Term &was = previous.at(i);
+        const Term &term = terms.at(i);
+        if (term.qmfClass != was.qmfClass)
+            return false;
+        // "queue:" then "queue:a"
+        if (was.type == Term::termClass)
+            continue;
+        if (term.type != was.type || !term.text.startsWith(was.text))
+            return false;
+    }
+    return true;
+}
+
+static bool resultLessThan(const SearchIndex::Result &a, const SearchIndex::Result &b)
+{
+    if (a.score != b.score)
+        return a.score > b.score;
+    return a.label < b.label;
+}
+
+SearchIndex::ResultList SearchIndex::search(const QString &query, int limit, QString *error) const
+{
+    ResultList results;
+    TermList terms;
+    if (!parse(query, terms, error) || terms.isEmpty()) {
+        lastValid = false;
+        return results;
+    }
+
+    // If the user only added to a plain text query, only the
+    // entries that matched last time need to be checked
+    bool plain = plainQuery(terms);
+    bool narrowing = plain && lastValid && narrows(terms, lastTerms);
+
+    QVector<Result> found;
+    QVector<int> matched;
+    int count = narrowing ? lastMatches.size() : entries.size();
+    for (int i=0; i<count; ++i) {
+        int idx = narrowing ? lastMatches.at(i) : i;
+        const Entry &entry = entries.at(idx);
+        int score = match(entry, terms);
+        if (score < 0)
+            continue;
+
+        Result result;
+        result.qmfClass = entry.qmfClass;
+        result.name = entry.name;
+        result.label = entry.label;
+        result.score = score;
+        found.append(result);
+        matched.append(idx);
+    }
+
+    lastValid = plain;
+    lastTerms = terms;
+    lastMatches = matched;
+
+    // only the best results need to be in order
+    int n = qMin(limit, found.size());
+    std::partial_sort(found.begin(), found.begin() + n, found.end(), resultLessThan);
+    for (int i=0; i<n; ++i)
+        results.append(found.at(i));
+
+    return results;
+}
@@ -0,0 +1,113 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+#include <QRegExp>
+#include "object-model.h"
+
+// A single index over the objects of every section.
+// Entries are added and removed as the dialogs' models gain and lose rows.
+//
+// A query is a list of terms separated by spaces. Every term must match:
+//   text             fuzzy (subsequence) match on the object name
+//   /regex/          regular expression match on the object name
+//   class:           only objects of this class (eg. queue: or queues:). A prefix
+//                    is allowed when only one class starts with it (eg. q:)
+//   class:text       both of the above
+//   field>N          numeric comparison on a property. >, >=, <, <=, = and != are allowed.
+//                    The field can be abbreviated (depth matches msgDepth)
+//   class:field>N    numeric comparison on objects of a single class
+class SearchIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SearchIndex(QObject *parent = 0);
+
+    void addModel(const QString &qmfClass, ObjectListModel *model);
+    ObjectListModel *model(const QString &qmfClass) const { return models.value(qmfClass, 0); }
+
+    struct Result {
+        QString qmfClass;
+        QString name;   // the unique property
+        QString label;  // the text shown in the dialog lists
+        int score;
+    };
+    typedef QList<Result> ResultList;
+
+    // error is set when the query can't be parsed
+    ResultList search(const QString &query, int limit, QString *error = 0) const;
+    int size() const { return entries.size(); }
+
+private slots:
+    void sourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void sourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+
+private:
+    struct Entry {
+        QString qmfClass;
+        ObjectListModel *model;
+        QString name;
+        QString label;
+        QString lower;
+    };
+
+    struct Term {
+        enum Type { termText, termRegex, termCompare, termClass };
+        Type type;
+        QString qmfClass;
+        QString text;
+        QRegExp regex;
+        QString field;
+        QString op;
+        qreal number;
+        QHash<QString, std::string> fields; // class -> resolved property
+    };
+    typedef QList<Term> TermList;
+
+    bool parse(const QString &query, TermList &terms, QString *error) const;
+    QString resolveClass(const QString &token, QString *error) const;
+    std::string resolveField(const Entry &entry, const QString &field) const;
+    int match(const Entry &entry, TermList &terms) const;
+    static int fuzzyScore(const QString &pattern, const QString &text);
+    static bool plainQuery(const TermList &terms);
+    static bool narrows(const TermList &terms, const TermList &previous);
+    static QString key(const QString &qmfClass, const QString &name) { return qmfClass + '\n' + name; }
+
+    void addEntry(const QString &qmfClass, ObjectListModel *model, int row);
+    void removeEntry(const QString &qmfClass, const QString &name);
+
+    QVector<Entry> entries;
+    QHash<QString, int> entryHash;          // class + name -> index in entries
+    QHash<QString, ObjectListModel *> models;
+    QHash<const QObject *, QString> modelClass;
+
+    // the matches for the last plain text query.
+    // A query that extends its terms can only match a subset of these
+    mutable TermList lastTerms;
+    mutable QVector<int> lastMatches;
+    mutable bool lastValid;
+};
+
+#endif // SEARCHINDEX_H
@@ -0,0 +1,424 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "segment-store.h"
+#include <QDir>
+#include <QSet>
+#include <QDateTime>
+#include <qnumeric.h>
+#include <string.h>
+#include <algorithm>
+
+static const char segmentMagic[] = "XVS1";
+
+namespace {
+
+// Orders the 'S' record offsets of an object by the wall clock time in the record
+struct RecordTime {
+    explicit RecordTime(const uchar *_map) : map(_map) {}
+    qint64 msecs(quint32 offset) const {
+        qint64 t;
+        memcpy(&t, map + offset + 5, 8);
+        return t;
+    }
+    bool operator()(quint32 offset, qint64 t) const { return msecs(offset) < t; }
+    bool operator()(qint64 t, quint32 offset) const { return t < msecs(offset); }
+    const uchar *map;
+};
+
+}
+
+SegmentStore::SegmentStore(QObject *parent, const QString &directory, const QStringList &props) :
+    QObject(parent),
+    dirty(false),
+    dir(directory),
+    properties(props),
+    retentionMSecs((qint64)24 * 3600 * 1000),
+    flushTimer(),
+    mutex(QMutex::Recursive)
+{
+    QDir().mkpath(dir);
+
+    // index whatever an earlier run left behind
+    QStringList files = QDir(dir).entryList(QStringList() << "*.seg", QDir::Files, QDir::Name);
+    QStringList::const_iterator iter = files.constBegin();
+    while (iter != files.constEnd()) {
+        Segment *segment = openSegment(QDir(dir).filePath(*iter));
+        if (segment)
+            segments.append(segment);
+        ++iter;
+    }
+    expire(QDateTime::currentMSecsSinceEpoch());
+
+    // samples are written to disk at least once a second
+    flushTimer.setInterval(1000);
+    connect(&flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+    flushTimer.start();
+}
+
+SegmentStore::~SegmentStore()
+{
+    flush();
+    qDeleteAll(segments);
+}
+
+void SegmentStore::attach(ObjectListModel *model)
+{
+    connect(model, SIGNAL(sampleAdded(QString,Sample)), this, SLOT(sampleAdded(QString,Sample)));
+}
+
+int SegmentStore::recordSize(int properties)
+{
+    return 1 + 4 + 8 + 8 + properties * (8 + 3 * 4);
+}
+
+bool SegmentStore::mapSegment(Segment *segment)
+{
+    qint64 size = segment->file.size();
+    if (segment->map && segment->mapped == size)
+        return true;
+    if (segment->map)
+        segment->file.unmap(segment->map);
+    segment->map = size > 0 ? segment->file.map(0, size) : 0;
+    segment->mapped = segment->map ? size : 0;
+    return segment->map != 0;
+}
+
+// Map a segment from an earlier run and build its index.
+// A record cut short by a crash ends the scan
+SegmentStore::Segment *SegmentStore::openSegment(const QString &path)
+{
+    Segment *segment = new Segment;
+    segment->file.setFileName(path);
+    segment->map = 0;
+    segment->mapped = 0;
+    segment->firstMSecs = 0;
+    segment->lastMSecs = 0;
+    if (!segment->file.open(QIODevice::ReadOnly) || !mapSegment(segment)) {
+        delete segment;
+        return 0;
+    }
+
+    const uchar *data = segment->map;
+    qint64 size = segment->mapped;
+    qint64 pos = 4;
+    quint32 count = 0;
+    if (size < 8 || memcmp(data, segmentMagic, 4) != 0) {
+        delete segment;
+        return 0;
+    }
+    memcpy(&count, data + pos, 4);
+    pos += 4;
+    for (quint32 i=0; i<count && pos + 4 <= size; ++i) {
+        quint32 len;
+        memcpy(&len, data + pos, 4);
+        pos += 4;
+        if (pos + len > size)
+            break;
+        segment->properties.append(QString::fromUtf8((const char *)data + pos, len));
+        pos += len;
+    }
+    segment->recordSize = recordSize(segment->properties.size());
+
+    while (pos < size) {
+        quint32 id;
+        if (data[pos] == 'N' && pos + 9 <= size) {
+            quint32 len;
+            memcpy(&id, data + pos + 1, 4);
+            memcpy(&len, data + pos + 5, 4);
+            if (pos + 9 + len > size)
+                break;
+            segment->names.insert(id, QString::fromUtf8((const char *)data + pos + 9, len));
+            pos += 9 + len;
+        } else if (data[pos] == 'S' && pos + segment->recordSize <= size) {
+            qint64 msecs;
+            memcpy(&id, data + pos + 1, 4);
+            memcpy(&msecs, data + pos + 5, 8);
+            segment->offsets[segment->names.value(id)].append((quint32)pos);
+            if (segment->firstMSecs == 0)
+                segment->firstMSecs = msecs;
+            segment->lastMSecs = msecs;
+            pos += segment->recordSize;
+        } else
+            break;
+    }
+    return segment;
+}
+
+// Begin a new segment for this run's samples
+void SegmentStore::startSegment(qint64 msecs)
+{
+    Segment *segment = new Segment;
+    segment->file.setFileName(QDir(dir).filePath(QString("%1.seg").arg(msecs)));
+    segment->map = 0;
+    segment->mapped = 0;
+    segment->properties = properties;
+    segment->recordSize = recordSize(properties.size());
+    segment->firstMSecs = msecs;
+    segment->lastMSecs = msecs;
+    if (!segment->file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        delete segment;
+        return;
+    }
+
+    QByteArray header(segmentMagic, 4);
+    quint32 count = properties.size();
+    header.append((const char *)&count, 4);
+    QStringList::const_iterator iter = properties.constBegin();
+    while (iter != properties.constEnd()) {
+        QByteArray utf8 = (*iter).toUtf8();
+        quint32 len = utf8.size();
+        header.append((const char *)&len, 4);
+        header.append(utf8);
+        ++iter;
+    }
+    segment->file.write(header);
+
+    segments.append(segment);
+    activeIds.clear();
+    expire(msecs);
+}
+
+// Remove the segments that hold nothing newer than the retention time
+void SegmentStore::expire(qint64 nowMSecs)
+{
+    while (segments.size() > 1 && segments.first()->lastMSecs < nowMSecs - retentionMSecs) {
+        Segment *segment = segments.takeFirst();
+        QString path = segment->file.fileName();
+        delete segment;
+        QFile::remove(path);
+    }
+}
+
+// SLOT triggered when the model receives a sample
+void SegmentStore::sampleAdded(const QString &name, const Sample &sample)
+{
+    QMutexLocker lock(&mutex);
+    qint64 msecs = sample.dateTime().toMSecsSinceEpoch();
+
+    // segments are never appended to across runs, so a new run starts a new one
+    if (segments.isEmpty() || !segments.last()->file.isWritable()
+        || segments.last()->file.pos() > segmentBytes || msecs - segments.last()->firstMSecs > segmentMSecs) {
+        flush();
+        startSegment(msecs);
+        if (segments.isEmpty() || !segments.last()->file.isWritable())
+            return;
+    }
+    Segment *segment = segments.last();
+
+    QByteArray record;
+    QHash<QString, quint32>::const_iterator found = activeIds.constFind(name);
+    quint32 id;
+    if (found == activeIds.constEnd()) {
+        id = activeIds.size();
+        activeIds.insert(name, id);
+        segment->names.insert(id, name);
+        QByteArray utf8 = name.toUtf8();
+        quint32 len = utf8.size();
+        record.append('N');
+        record.append((const char *)&id, 4);
+        record.append((const char *)&len, 4);
+        record.append(utf8);
+    } else
+        id = found.value();
+
+    segment->offsets[name].append((quint32)(segment->file.pos() + record.size()));
+    qint64 updateTime = sample.updateTime();
+    record.append('S');
+    record.append((const char *)&id, 4);
+    record.append((const char *)&msecs, 8);
+    record.append((const char *)&updateTime, 8);
+    QStringList::const_iterator iter = properties.constBegin();
+    while (iter != properties.constEnd()) {
+        qint64 value = sample.data(*iter);
+        record.append((const char *)&value, 8);
+        ++iter;
+    }
+    iter = properties.constBegin();
+    while (iter != properties.constEnd()) {
+        float rates[3] = {(float)qQNaN(), (float)qQNaN(), (float)qQNaN()};
+        if (sample.hasRate(*iter)) {
+            SampleRate rate = sample.rate(*iter);
+            rates[0] = rate.instant;
+            rates[1] = rate.avg1m;
+            rates[2] = rate.avg5m;
+        }
+        record.append((const char *)rates, sizeof(rates));
+        ++iter;
+    }
+
+    segment->file.write(record);
+    segment->lastMSecs = msecs;
+    dirty = true;
+}
+
+// SLOT triggered by the flush timer
+void SegmentStore::flush()
+{
+    QMutexLocker lock(&mutex);
+    if (dirty && !segments.isEmpty())
+        segments.last()->file.flush();
+    dirty = false;
+}
+
+// The offsets of the records that are wholly inside the mapped part of the file
+QVector<quint32>::const_iterator SegmentStore::mappedEnd(const Segment *segment, const QVector<quint32> &offsets)
+{
+    if (segment->mapped < segment->recordSize)
+        return offsets.constBegin();
+    return std::upper_bound(offsets.constBegin(), offsets.constEnd(), (quint32)(segment->mapped - segment->recordSize));
+}
+
+// Build a sample from an 'S' record.
+// Wall clock times are translated into this run's monotonic clock
+Sample SegmentStore::decode(const Segment *segment, const uchar *record, qint64 nowMSecs, qint64 nowClock)
+{
+    qint64 msecs;
+    qint64 updateTime;
+    memcpy(&msecs, record + 5, 8);
+    memcpy(&updateTime, record + 13, 8);
+
+    Sample sample;
+    sample.setDateTime(QDateTime::fromMSecsSinceEpoch(msecs));
+    sample.setClock(nowClock - (nowMSecs - msecs) * 1000000);
+    sample.setUpdateTime(updateTime);
+    int count = segment->properties.size();
+    const uchar *values = record + 21;
+    const uchar *rates = values + count * 8;
+    for (int i=0; i<count; ++i) {
+        qint64 value;
+        memcpy(&value, values + i * 8, 8);
+        sample.setProperty(segment->properties.at(i), value);
+
+        float r[3];
+        memcpy(r, rates + i * sizeof(r), sizeof(r));
+        if (!qIsNaN(r[0])) {
+            SampleRate rate;
+            rate.instant = r[0];
+            rate.avg1m = r[1];
+            rate.avg5m = r[2];
+            sample.setRate(segment->properties.at(i), rate);
+        }
+    }
+    return sample;
+}
+
+ObjectListModel::SampleList SegmentStore::read(const QString &name, qint64 fromMSecs, qint64 toMSecs)
+{
+    QMutexLocker lock(&mutex);
+    ObjectListModel::SampleList list;
+    flush();
+
+    qint64 nowMSecs = QDateTime::currentMSecsSinceEpoch();
+    qint64 nowClock = Sample::now();
+
+    QList<Segment *>::const_iterator iSegment = segments.constBegin();
+    while (iSegment != segments.constEnd()) {
+        Segment *segment = *iSegment;
+        ++iSegment;
+        if (segment->lastMSecs < fromMSecs || segment->firstMSecs > toMSecs)
+            continue;
+        QHash<QString, QVector<quint32> >::const_iterator found = segment->offsets.constFind(name);
+        if (found == segment->offsets.constEnd() || !mapSegment(segment))
+            continue;
+
+        const QVector<quint32> &offsets = found.value();
+        QVector<quint32>::const_iterator end = mappedEnd(segment, offsets);
+        QVector<quint32>::const_iterator iOffset = std::lower_bound(offsets.constBegin(), end, fromMSecs, RecordTime(segment->map));
+        for (; iOffset != end; ++iOffset) {
+            const uchar *record = segment->map + *iOffset;
+            qint64 msecs;
+            memcpy(&msecs, record + 5, 8);
+            if (msecs > toMSecs)
+                break;
+            list.append(decode(segment, record, nowMSecs, nowClock));
+        }
+    }
+    return list;
+}
+
+bool SegmentStore::sampleAt(const QString &name, qint64 msecs, Sample &sample)
+{
+    QMutexLocker lock(&mutex);
+    flush();
+
+    // the newest segment that has a sample old enough
+    for (int i=segments.size() - 1; i>=0; --i) {
+        Segment *segment = segments.at(i);
+        if (segment->firstMSecs > msecs)
+            continue;
+        QHash<QString, QVector<quint32> >::const_iterator found = segment->offsets.constFind(name);
+        if (found == segment->offsets.constEnd() || !mapSegment(segment))
+            continue;
+
+        const QVector<quint32> &offsets = found.value();
+        QVector<quint32>::const_iterator iOffset = std::upper_bound(offsets.constBegin(), mappedEnd(segment, offsets), msecs, RecordTime(segment->map));
+        if (iOffset == offsets.constBegin())
+            continue;
+        --iOffset;
+        sample = decode(segment, segment->map + *iOffset, QDateTime::currentMSecsSinceEpoch(), Sample::now());
+        return true;
+    }
+    return false;
+}
+
+qint64 SegmentStore::firstSeen(const QString &name)
+{
+    QMutexLocker lock(&mutex);
+    QList<Segment *>::const_iterator iSegment = segments.constBegin();
+    while (iSegment != segments.constEnd()) {
+        Segment *segment = *iSegment;
+        ++iSegment;
+        QHash<QString, QVector<quint32> >::const_iterator found = segment->offsets.constFind(name);
+        if (found == segment->offsets.constEnd() || !mapSegment(segment))
+            continue;
+        if (mappedEnd(segment, found.value()) == found.value().constBegin())
+            continue;
+        return RecordTime(segment->map).msecs(found.value().first());
+    }
+    return 0;
+}
+
+QStringList SegmentStore::names()
+{
+    QMutexLocker lock(&mutex);
+    QSet<QString> set;
+    QList<Segment *>::const_iterator iSegment = segments.constBegin();
+    while (iSegment != segments.constEnd()) {
+        QHash<QString, QVector<quint32> >::const_iterator iter = (*iSegment)->offsets.constBegin();
+        while (iter != (*iSegment)->offsets.constEnd()) {
+            set.insert(iter.key());
+            ++iter;
+        }
+        ++iSegment;
+    }
+    return set.toList();
+}
+
+int SegmentStore::count(const QString &name)
+{
+    QMutexLocker lock(&mutex);
+    int total = 0;
+    QList<Segment *>::const_iterator iSegment = segments.constBegin();
+    while (iSegment != segments.constEnd()) {
+        total += (*iSegment)->offsets.value(name).size();
+        ++iSegment;
+    }
+    return total;
+}
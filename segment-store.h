@@ -0,0 +1,109 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef SEGMENTSTORE_H
+#define SEGMENTSTORE_H
+
+#include <QObject>
+#include <QFile>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+#include <QTimer>
+#include <QMutex>
+#include "object-model.h"
+
+// On-disk history for one model.
+// Every sample is appended to the current segment file in the store's
+// directory. Segments are read through memory maps, with an in-memory index
+// of the record offsets of each object, so old history can be charted without
+// keeping it resident. An object's offsets are in time order, so a time is
+// found with a binary search rather than a scan. Segments left by an earlier
+// run are indexed when the store is opened, and are deleted once they are
+// older than the retention time. Reads can come from another thread, such as
+// a history export, so they are serialized with the writes.
+//
+// Segment layout, in host byte order:
+//   header: "XVS1", quint32 property count, each property as quint32 length + UTF-8
+//   'N' record: quint32 object id, quint32 length, UTF-8 object name
+//   'S' record: quint32 object id, qint64 wall clock msecs, qint64 broker update time,
+//               a qint64 value per property, then instant, 1m and 5m rates as
+//               floats per property. A NaN rate means the sample had no rate.
+class SegmentStore : public QObject
+{
+    Q_OBJECT
+public:
+    SegmentStore(QObject *parent, const QString &directory, const QStringList &properties);
+    ~SegmentStore();
+
+    // record every sample that model receives
+    void attach(ObjectListModel *model);
+
+    // the stored samples of one object between two wall clock times, oldest first
+    ObjectListModel::SampleList read(const QString &name, qint64 fromMSecs, qint64 toMSecs);
+    // the latest stored sample of one object at or before a wall clock time
+    bool sampleAt(const QString &name, qint64 msecs, Sample &sample);
+    // the wall clock time of the oldest stored sample of one object, 0 if none
+    qint64 firstSeen(const QString &name);
+    // the objects with stored samples, and how many each has
+    QStringList names();
+    int count(const QString &name);
+
+    QString directory() const { return dir; }
+    void setRetention(int hours) { retentionMSecs = (qint64)hours * 3600 * 1000; }
+
+    static const qint64 segmentBytes = 8 * 1024 * 1024;
+    static const qint64 segmentMSecs = 60 * 60 * 1000;
+
+private slots:
+    void sampleAdded(const QString &name, const Sample &sample);
+    void flush();
+
+private:
+    struct Segment {
+        QFile file;
+        uchar *map;
+        qint64 mapped;
+        QStringList properties;
+        int recordSize;
+        qint64 firstMSecs;
+        qint64 lastMSecs;
+        QHash<quint32, QString> names;
+        QHash<QString, QVector<quint32> > offsets;  // object -> 'S' records
+    };
+    QList<Segment *> segments;  // oldest first, the last one is being written
+    QHash<QString, quint32> activeIds;
+    bool dirty;
+
+    QString dir;
+    QStringList properties;
+    qint64 retentionMSecs;
+    QTimer flushTimer;
+    QMutex mutex;
+
+    static int recordSize(int properties);
+    Segment *openSegment(const QString &path);
+    void startSegment(qint64 msecs);
+    void expire(qint64 nowMSecs);
+    bool mapSegment(Segment *segment);
+    static QVector<quint32>::const_iterator mappedEnd(const Segment *segment, const QVector<quint32> &offsets);
+    static Sample decode(const Segment *segment, const uchar *record, qint64 nowMSecs, qint64 nowClock);
+};
+
+#endif // SEGMENTSTORE_H
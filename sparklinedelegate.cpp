@@ -0,0 +1,154 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "sparklinedelegate.h"
+#include <QAbstractProxyModel>
+#include <QPainter>
+#include <QPainterPath>
+#include <QVector>
+#include <QStyle>
+
+SparklineDelegate::SparklineDelegate(QObject *parent, ObjectListModel *_model, const QString &_property, bool _rate) :
+    QItemDelegate(parent),
+    model(_model),
+    property(_property),
+    rate(_rate),
+    glyphs(cacheSize)
+{
+}
+
+void SparklineDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    QStyleOptionViewItem nameOption(option);
+    if (option.rect.width() > sparkWidth * 2)
+        nameOption.rect.setRight(option.rect.right() - sparkWidth - 4);
+    QItemDelegate::paint(painter, nameOption, index);
+    if (nameOption.rect == option.rect)
+        return;
+
+    // carry a highlighted row's background under the sparkline
+    QVariant background = index.data(Qt::BackgroundRole);
+    if (background.canConvert<QBrush>() && !(option.state & QStyle::State_Selected)) {
+        QRect rest(option.rect);
+        rest.setLeft(nameOption.rect.right() + 1);
+        painter->fillRect(rest, qvariant_cast<QBrush>(background));
+    }
+
+    // the view may be showing the model through a filter
+    QModelIndex source = index;
+    const QAbstractProxyModel *proxy = qobject_cast<const QAbstractProxyModel *>(index.model());
+    if (proxy)
+        source = proxy->mapToSource(index);
+    if (!source.isValid())
+        return;
+
+    QSize size(sparkWidth, option.rect.height() - 4);
+    if (size.height() < 4)
+        return;
+    QPixmap *pixmap = glyph(model->uniqueName(source.row()), size);
+    if (pixmap)
+        painter->drawPixmap(option.rect.right() - sparkWidth, option.rect.top() + 2, *pixmap);
+}
+
+// The cached chart of an object, drawn if this is the first time it is
+// needed since the object's last sample
+QPixmap *SparklineDelegate::glyph(const QString &name, const QSize &size) const
+{
+    const ObjectListModel::Samples &samples(model->samples());
+    ObjectListModel::const_iterSamples found = samples.constFind(name);
+    if (found == samples.constEnd() || found.value().size() < 2)
+        return 0;
+    const ObjectListModel::SampleList &list = found.value();
+
+    SampleRate::Window window = model->getRateWindow();
+    QString key = QString("%1/%2/%3/%4x%5").arg(name).arg(list.last().clock()).arg(window)
+                  .arg(size.width()).arg(size.height());
+    QPixmap *pixmap = glyphs.object(key);
+    if (pixmap)
+        return pixmap;
+
+    // the min and max in each pixel column, over the samples that are kept.
+    // The chart ends at the latest sample so the pixmap doesn't depend on when it is drawn
+    int columns = size.width();
+    QVector<qreal> lo(columns);
+    QVector<qreal> hi(columns);
+    QVector<bool> used(columns, false);
+    qreal minimum = 0.0;
+    qreal maximum = 0.0;
+    qint64 right = list.last().clock();
+    qint64 span = right - list.first().clock();
+    if (span <= 0)
+        return 0;
+
+    ObjectListModel::const_iterSampleList iter = list.constBegin();
+    while (iter != list.constEnd()) {
+        const Sample &sample = *iter;
+        ++iter;
+        qreal value;
+        if (rate) {
+            if (!sample.hasRate(property))
+                continue;
+            value = sample.rate(property).value(window);
+        } else
+            value = sample.data(property);
+
+        int col = qBound(0, (int)((sample.clock() - (right - span)) * (columns - 1) / span), columns - 1);
+        if (!used[col]) {
+            used[col] = true;
+            lo[col] = value;
+            hi[col] = value;
+        } else {
+            lo[col] = qMin(lo[col], value);
+            hi[col] = qMax(hi[col], value);
+        }
+        minimum = qMin(minimum, value);
+        maximum = qMax(maximum, value);
+    }
+    qreal range = maximum - minimum;
+    if (range <= 0)
+        range = 1;
+
+    pixmap = new QPixmap(size);
+    pixmap->fill(Qt::transparent);
+    QPainter painter(pixmap);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QColor(60, 110, 180));
+
+    qreal bottom = size.height() - 1;
+    QPainterPath path;
+    bool moved = false;
+    for (int col=0; col<columns; ++col) {
+        if (!used.at(col))
+            continue;
+        qreal yHi = bottom - (hi.at(col) - minimum) / range * bottom;
+        qreal yLo = bottom - (lo.at(col) - minimum) / range * bottom;
+        if (!moved) {
+            path.moveTo(col + 0.5, yHi);
+            moved = true;
+        } else
+            path.lineTo(col + 0.5, yHi);
+        if (yLo != yHi)
+            path.lineTo(col + 0.5, yLo);
+    }
+    painter.drawPath(path);
+    painter.end();
+
+    glyphs.insert(key, pixmap);
+    return pixmap;
+}
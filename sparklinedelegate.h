@@ -0,0 +1,53 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef SPARKLINEDELEGATE_H
+#define SPARKLINEDELEGATE_H
+
+#include <QItemDelegate>
+#include <QCache>
+#include <QPixmap>
+#include "object-model.h"
+
+// Draws the object's name with a small chart of one property to its right.
+// The charts are drawn into pixmaps that are cached by object, latest sample
+// and size, so a row is only redrawn when it gets a new sample. The view only
+// paints the rows that are visible.
+class SparklineDelegate : public QItemDelegate
+{
+    Q_OBJECT
+public:
+    // chart the per second rate of the property, or its value
+    SparklineDelegate(QObject *parent, ObjectListModel *model, const QString &property, bool rate);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const;
+
+    static const int sparkWidth = 60;
+    static const int cacheSize = 2000;  // pixmaps
+
+private:
+    ObjectListModel *model;
+    QString property;
+    bool rate;
+    mutable QCache<QString, QPixmap> glyphs;
+
+    QPixmap *glyph(const QString &name, const QSize &size) const;
+};
+
+#endif // SPARKLINEDELEGATE_H
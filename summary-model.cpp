@@ -0,0 +1,97 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "summary-model.h"
+
+SummaryModel::SummaryModel(QObject *parent) :
+    QAbstractTableModel(parent),
+    rowList(),
+    showIcons(false),
+    backgroundColor()
+{
+}
+
+int SummaryModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return rowList.size();
+}
+
+int SummaryModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return showIcons ? 3 : 2;
+}
+
+QVariant SummaryModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rowList.size())
+        return QVariant();
+
+    const Row& row = rowList.at(index.row());
+    int col = index.column();
+
+    if (role == Qt::BackgroundRole)
+        return backgroundColor;
+
+    if (col == valueColumn()) {
+        if (role == Qt::DisplayRole)
+            return row.value;
+        if (role == Qt::TextAlignmentRole)
+            return (int)row.alignment;
+    } else if (col == headerColumn()) {
+        if (role == Qt::DisplayRole)
+            return row.header;
+    } else if (role == Qt::DecorationRole && !row.icon.isNull())
+        return row.icon;
+
+    return QVariant();
+}
+
+bool SummaryModel::setRows(const QList<Row>& rows, bool icons, const QColor& background, QList<int> *changed)
+{
+    bool reshape = (rows.size() != rowList.size()) || (icons != showIcons) || (background != backgroundColor);
+    for (int i=0; !reshape && i<rows.size(); ++i)
+        if (rows.at(i).header != rowList.at(i).header)
+            reshape = true;
+
+    if (reshape) {
+        beginResetModel();
+        rowList = rows;
+        showIcons = icons;
+        backgroundColor = background;
+        endResetModel();
+        return true;
+    }
+
+    // same rows, just new values
+    int col = valueColumn();
+    for (int i=0; i<rows.size(); ++i) {
+        if (rows.at(i).value != rowList.at(i).value) {
+            rowList[i].value = rows.at(i).value;
+            QModelIndex cell = index(i, col);
+            emit dataChanged(cell, cell);
+            if (changed)
+                changed->append(i);
+        }
+    }
+    return false;
+}
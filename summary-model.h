@@ -0,0 +1,64 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef SUMMARYMODEL_H
+#define SUMMARYMODEL_H
+
+#include <QAbstractTableModel>
+#include <QIcon>
+#include <QColor>
+#include <QList>
+
+// The model behind the small table of current values that is shown
+// under each section's object name. The rows are kept between refreshes
+// so an update only touches the value cells that actually changed.
+class SummaryModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    struct Row {
+        QString value;
+        QString header;
+        Qt::Alignment alignment;
+        QIcon icon;
+    };
+
+    explicit SummaryModel(QObject *parent = 0);
+
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    virtual int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+    // Replace the rows. Returns true if the table's shape changed and its
+    // geometry needs to be recalculated. Otherwise changed is filled with
+    // the rows whose values are different.
+    bool setRows(const QList<Row>& rows, bool icons, const QColor& background, QList<int> *changed);
+
+    int valueColumn() const { return showIcons ? 1 : 0; }
+    int headerColumn() const { return showIcons ? 2 : 1; }
+    const Row& row(int i) const { return rowList.at(i); }
+
+private:
+    QList<Row> rowList;
+    bool showIcons;
+    QColor backgroundColor;
+};
+
+#endif // SUMMARYMODEL_H
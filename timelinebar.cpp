@@ -0,0 +1,111 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "timelinebar.h"
+#include <QDateTime>
+
+TimelineBar::TimelineBar(QWidget *parent) :
+    QToolBar(tr("Timeline"), parent),
+    settleTimer(),
+    anchorMSecs(0),
+    viewMSecs(0)
+{
+    setObjectName("Timeline");
+
+    slider = new QSlider(Qt::Horizontal, this);
+    slider->setRange(0, 600);
+    slider->setValue(600);
+    slider->setMinimumWidth(300);
+    slider->setPageStep(60);
+    addWidget(slider);
+
+    label = new QLabel(this);
+    label->setMinimumWidth(label->fontMetrics().width("0000-00-00 00:00:00 (-00:00:00)") + 8);
+    addWidget(label);
+
+    liveButton = new QToolButton(this);
+    liveButton->setText(tr("Live"));
+    liveButton->setCheckable(true);
+    liveButton->setChecked(true);
+    addWidget(liveButton);
+
+    settleTimer.setSingleShot(true);
+    settleTimer.setInterval(settleInterval);
+
+    connect(slider, SIGNAL(valueChanged(int)), this, SLOT(sliderChanged(int)));
+    connect(liveButton, SIGNAL(clicked()), this, SLOT(goLive()));
+    connect(&settleTimer, SIGNAL(timeout()), this, SLOT(seek()));
+
+    updateLabel();
+}
+
+void TimelineBar::setSpan(int secs)
+{
+    int back = slider->maximum() - slider->value();
+    slider->blockSignals(true);
+    slider->setMaximum(secs);
+    slider->setValue(qMax(0, secs - back));
+    slider->blockSignals(false);
+    sliderChanged(slider->value());
+}
+
+// SLOT triggered by the Live button
+void TimelineBar::goLive()
+{
+    slider->setValue(slider->maximum());
+    liveButton->setChecked(true);
+}
+
+// SLOT triggered when the slider moves
+// The sections are only moved once the slider settles
+void TimelineBar::sliderChanged(int value)
+{
+    int back = slider->maximum() - value;
+    if (back == 0)
+        viewMSecs = 0;
+    else {
+        // the view stops following now the moment the slider leaves the right end
+        if (viewMSecs == 0)
+            anchorMSecs = QDateTime::currentMSecsSinceEpoch();
+        viewMSecs = anchorMSecs - (qint64)back * 1000;
+    }
+    liveButton->setChecked(viewMSecs == 0);
+    updateLabel();
+    settleTimer.start();
+}
+
+// SLOT triggered by the settle timer
+void TimelineBar::seek()
+{
+    emit viewTimeChanged(viewMSecs);
+}
+
+void TimelineBar::updateLabel()
+{
+    if (viewMSecs == 0) {
+        label->setText(tr("Now"));
+        return;
+    }
+    int back = slider->maximum() - slider->value();
+    label->setText(QString("%1 (-%2:%3:%4)")
+                   .arg(QDateTime::fromMSecsSinceEpoch(viewMSecs).toString("yyyy-MM-dd hh:mm:ss"))
+                   .arg(back / 3600)
+                   .arg((back / 60) % 60, 2, 10, QChar('0'))
+                   .arg(back % 60, 2, 10, QChar('0')));
+}
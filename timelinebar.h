@@ -0,0 +1,68 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef TIMELINEBAR_H
+#define TIMELINEBAR_H
+
+#include <QToolBar>
+#include <QSlider>
+#include <QLabel>
+#include <QToolButton>
+#include <QTimer>
+
+// A toolbar with a slider that moves the sections back through the
+// recorded history. The right end of the slider is now. Moving it away
+// freezes the view at that many seconds before the moment it was moved,
+// and the Live button goes back to following new samples.
+class TimelineBar : public QToolBar
+{
+    Q_OBJECT
+
+public:
+    explicit TimelineBar(QWidget *parent);
+
+    // how far back the slider reaches
+    void setSpan(int secs);
+    qint64 viewTime() const { return viewMSecs; }
+
+    static const int settleInterval = 40; // msec to wait for the slider to stop before seeking
+
+signals:
+    // the wall clock time to show, 0 for now
+    void viewTimeChanged(qint64 msecs);
+
+public slots:
+    void goLive();
+
+private slots:
+    void sliderChanged(int value);
+    void seek();
+
+private:
+    QSlider *slider;
+    QLabel *label;
+    QToolButton *liveButton;
+    QTimer settleTimer;
+    qint64 anchorMSecs;     // the time at the right end of the slider while not live
+    qint64 viewMSecs;
+
+    void updateLabel();
+};
+
+#endif // TIMELINEBAR_H
@@ -0,0 +1,315 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "topology-aggregator.h"
+
+TopologyAggregator::TopologyAggregator(QObject *parent) :
+    QObject(parent),
+    rollups()
+{
+}
+
+TopologyAggregator::~TopologyAggregator()
+{
+    qDeleteAll(rollups);
+}
+
+int TopologyAggregator::addRollup(const QString &title, ObjectListModel *members, const std::string &groupRef,
+                                  const QString &property, bool rate, Op op)
+{
+    Rollup *rollup = new Rollup;
+    rollup->title = title;
+    rollup->members = members;
+    rollup->links = 0;
+    rollup->groupRef = groupRef;
+    rollup->property = property;
+    rollup->rate = rate;
+    rollup->op = op;
+    return add(rollup);
+}
+
+int TopologyAggregator::addRollup(const QString &title, ObjectListModel *members, ObjectListModel *links,
+                                  const std::string &groupRef, const std::string &memberRef,
+                                  const QString &property, bool rate, Op op)
+{
+    Rollup *rollup = new Rollup;
+    rollup->title = title;
+    rollup->members = members;
+    rollup->links = links;
+    rollup->groupRef = groupRef;
+    rollup->memberRef = memberRef;
+    rollup->property = property;
+    rollup->rate = rate;
+    rollup->op = op;
+    return add(rollup);
+}
+
+int TopologyAggregator::add(Rollup *rollup)
+{
+    rollups.append(rollup);
+
+    // several rollups can share a model. Only connect once
+    if (!sampledModels.contains(rollup->members)) {
+        sampledModels.append(rollup->members);
+        connect(rollup->members, SIGNAL(sampleAdded(QString,Sample)), this, SLOT(sampleAdded(QString,Sample)));
+    }
+    watch(rollup->members);
+    if (rollup->links) {
+        watch(rollup->links);
+        if (!linkModels.contains(rollup->links)) {
+            linkModels.append(rollup->links);
+            connect(rollup->links, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(linksInserted(QModelIndex,int,int)));
+        }
+        addLinks(rollup, 0, rollup->links->rowCount() - 1);
+    }
+    return rollups.size() - 1;
+}
+
+void TopologyAggregator::watch(ObjectListModel *model)
+{
+    if (watchedModels.contains(model))
+        return;
+    watchedModels.append(model);
+    connect(model, SIGNAL(objectRemoved(QString)), this, SLOT(objectRemoved(QString)));
+    connect(model, SIGNAL(objectsCleared()), this, SLOT(objectsCleared()));
+}
+
+bool TopologyAggregator::value(int index, const QString &name, qreal &result, int *count) const
+{
+    const Rollup *rollup = rollups.at(index);
+    QHash<QString, Group>::const_iterator found = rollup->groups.constFind(name);
+    if (found == rollup->groups.constEnd() || found.value().count == 0)
+        return false;
+
+    const Group &group = found.value();
+    if (rollup->op == opMax)
+        result = (group.values.constEnd() - 1).key();
+    else if (rollup->op == opAverage)
+        result = group.sum / group.count;
+    else
+        result = group.sum;
+    if (count)
+        *count = group.count;
+    return true;
+}
+
+// The part of a qmf object name after the package and class,
+// e.g. org.apache.qpid.broker:queue:my-queue -> my-queue.
+// The name can hold colons itself, as a connection's address does
+QString TopologyAggregator::refName(const std::string &objectName)
+{
+    return QString(objectName.c_str()).section(':', 2, -1);
+}
+
+// SLOT triggered when a model adds a sample for an object
+void TopologyAggregator::sampleAdded(const QString &name, const Sample &sample)
+{
+    ObjectListModel *model = (ObjectListModel *)sender();
+    QList<Rollup *>::const_iterator iter = rollups.constBegin();
+    while (iter != rollups.constEnd()) {
+        Rollup *rollup = *iter;
+        ++iter;
+        if (rollup->members != model)
+            continue;
+
+        if (!rollup->links && !rollup->memberGroups.contains(name)) {
+            // the sample of a new object arrives before its row is added.
+            // It joins its group with its next sample
+            int row = model->findRow(name);
+            if (row < 0)
+                continue;
+            join(rollup, refName(model->fieldValue(row, rollup->groupRef)), name);
+        }
+
+        if (rollup->rate) {
+            if (sample.hasRate(rollup->property))
+                update(rollup, name, sample.rate(rollup->property).value(model->getRateWindow()));
+        } else
+            update(rollup, name, (qreal)sample.data(rollup->property));
+    }
+}
+
+// SLOT triggered when an object is gone from the broker
+void TopologyAggregator::objectRemoved(const QString &name)
+{
+    ObjectListModel *model = (ObjectListModel *)sender();
+    QList<Rollup *>::const_iterator iter = rollups.constBegin();
+    while (iter != rollups.constEnd()) {
+        Rollup *rollup = *iter;
+        ++iter;
+        if (rollup->members == model) {
+            remove(rollup, name);
+            if (!rollup->links)
+                rollup->memberGroups.remove(name);
+        }
+        if (rollup->links == model && rollup->linkPairs.contains(name)) {
+            QPair<QString, QString> pair = rollup->linkPairs.take(name);
+            if (--rollup->pairLinks[pair] <= 0) {
+                rollup->pairLinks.remove(pair);
+                leave(rollup, pair.first, pair.second);
+            }
+        }
+    }
+}
+
+// SLOT triggered when a model drops its objects or its samples
+void TopologyAggregator::objectsCleared()
+{
+    ObjectListModel *model = (ObjectListModel *)sender();
+    QList<Rollup *>::const_iterator iter = rollups.constBegin();
+    while (iter != rollups.constEnd()) {
+        Rollup *rollup = *iter;
+        ++iter;
+        if (rollup->members == model) {
+            rollup->current.clear();
+            rollup->groups.clear();
+            if (!rollup->links)
+                rollup->memberGroups.clear();
+        }
+        // the links are only forgotten when their objects are, not their samples
+        if (rollup->links == model && model->rowCount() == 0) {
+            QHash<QString, QPair<QString, QString> >::const_iterator pair = rollup->linkPairs.constBegin();
+            while (pair != rollup->linkPairs.constEnd()) {
+                if (rollup->pairLinks.contains(pair.value())) {
+                    rollup->pairLinks.remove(pair.value());
+                    leave(rollup, pair.value().first, pair.value().second);
+                }
+                ++pair;
+            }
+            rollup->linkPairs.clear();
+        }
+    }
+}
+
+// SLOT triggered when linking objects are added
+void TopologyAggregator::linksInserted(const QModelIndex &, int first, int last)
+{
+    ObjectListModel *model = (ObjectListModel *)sender();
+    QList<Rollup *>::const_iterator iter = rollups.constBegin();
+    while (iter != rollups.constEnd()) {
+        if ((*iter)->links == model)
+            addLinks(*iter, first, last);
+        ++iter;
+    }
+}
+
+// Each new link between a group and a member adds the member to the group
+void TopologyAggregator::addLinks(Rollup *rollup, int first, int last)
+{
+    ObjectListModel *links = rollup->links;
+    for (int row=first; row<=last; ++row) {
+        QString name = links->uniqueName(row);
+        if (rollup->linkPairs.contains(name))
+            continue;
+        QPair<QString, QString> pair(refName(links->fieldValue(row, rollup->groupRef)),
+                                     refName(links->fieldValue(row, rollup->memberRef)));
+        rollup->linkPairs.insert(name, pair);
+        if (++rollup->pairLinks[pair] == 1)
+            join(rollup, pair.first, pair.second);
+    }
+}
+
+// A member's new value replaces its old one in each of its groups
+void TopologyAggregator::update(Rollup *rollup, const QString &member, qreal value)
+{
+    QHash<QString, qreal>::iterator found = rollup->current.find(member);
+    bool had = found != rollup->current.end();
+    if (had && found.value() == value)
+        return;
+
+    const QStringList groups = rollup->memberGroups.value(member);
+    QStringList::const_iterator iter = groups.constBegin();
+    while (iter != groups.constEnd()) {
+        Group &group = rollup->groups[*iter];
+        if (had)
+            removeValue(rollup, group, found.value());
+        addValue(rollup, group, value);
+        ++iter;
+    }
+    rollup->current.insert(member, value);
+}
+
+// Take a member's value out of all its groups
+void TopologyAggregator::remove(Rollup *rollup, const QString &member)
+{
+    QHash<QString, qreal>::iterator found = rollup->current.find(member);
+    if (found == rollup->current.end())
+        return;
+
+    const QStringList groups = rollup->memberGroups.value(member);
+    QStringList::const_iterator iter = groups.constBegin();
+    while (iter != groups.constEnd()) {
+        QHash<QString, Group>::iterator group = rollup->groups.find(*iter);
+        if (group != rollup->groups.end()) {
+            removeValue(rollup, group.value(), found.value());
+            if (group.value().count == 0)
+                rollup->groups.erase(group);
+        }
+        ++iter;
+    }
+    rollup->current.erase(found);
+}
+
+void TopologyAggregator::join(Rollup *rollup, const QString &group, const QString &member)
+{
+    QStringList &groups = rollup->memberGroups[member];
+    if (groups.contains(group))
+        return;
+    groups.append(group);
+
+    QHash<QString, qreal>::const_iterator found = rollup->current.constFind(member);
+    if (found != rollup->current.constEnd())
+        addValue(rollup, rollup->groups[group], found.value());
+}
+
+void TopologyAggregator::leave(Rollup *rollup, const QString &group, const QString &member)
+{
+    QHash<QString, QStringList>::iterator groups = rollup->memberGroups.find(member);
+    if (groups == rollup->memberGroups.end() || !groups.value().removeOne(group))
+        return;
+    if (groups.value().isEmpty())
+        rollup->memberGroups.erase(groups);
+
+    QHash<QString, qreal>::const_iterator found = rollup->current.constFind(member);
+    QHash<QString, Group>::iterator sums = rollup->groups.find(group);
+    if (found != rollup->current.constEnd() && sums != rollup->groups.end()) {
+        removeValue(rollup, sums.value(), found.value());
+        if (sums.value().count == 0)
+            rollup->groups.erase(sums);
+    }
+}
+
+void TopologyAggregator::addValue(Rollup *rollup, Group &group, qreal value)
+{
+    group.sum += value;
+    ++group.count;
+    if (rollup->op == opMax)
+        ++group.values[value];
+}
+
+void TopologyAggregator::removeValue(Rollup *rollup, Group &group, qreal value)
+{
+    group.sum -= value;
+    --group.count;
+    if (rollup->op == opMax) {
+        QMap<qreal, int>::iterator found = group.values.find(value);
+        if (found != group.values.end() && --found.value() <= 0)
+            group.values.erase(found);
+    }
+}
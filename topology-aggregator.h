@@ -0,0 +1,113 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef TOPOLOGYAGGREGATOR_H
+#define TOPOLOGYAGGREGATOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QStringList>
+#include "object-model.h"
+
+// Keeps running totals of a property over the objects related to another
+// object, e.g. the enqueue rate of all the queues bound to an exchange or
+// the unacked messages of all the sessions of a connection.
+// Objects are grouped by the same ref fields the related sections filter on.
+// Each new sample only moves its own object's contribution, so reading a
+// total never has to add up the group again.
+class TopologyAggregator : public QObject
+{
+    Q_OBJECT
+public:
+    enum Op {
+        opSum,
+        opAverage,
+        opMax
+    };
+
+    explicit TopologyAggregator(QObject *parent = 0);
+    ~TopologyAggregator();
+
+    // group the members by the object named in their groupRef field
+    int addRollup(const QString &title, ObjectListModel *members, const std::string &groupRef,
+                  const QString &property, bool rate, Op op);
+    // group the members through a linking class. Each link names a group in
+    // groupRef and a member in memberRef, like a binding's exchange and queue
+    int addRollup(const QString &title, ObjectListModel *members, ObjectListModel *links,
+                  const std::string &groupRef, const std::string &memberRef,
+                  const QString &property, bool rate, Op op);
+
+    // the rollup's value for one group, false if the group has no members with values
+    bool value(int rollup, const QString &group, qreal &result, int *count = 0) const;
+    QString title(int rollup) const { return rollups.at(rollup)->title; }
+    bool isRate(int rollup) const { return rollups.at(rollup)->rate; }
+
+    // the name a ref field points at, as it appears in the referred object's unique property
+    static QString refName(const std::string &objectName);
+
+private slots:
+    void sampleAdded(const QString &name, const Sample &sample);
+    void objectRemoved(const QString &name);
+    void objectsCleared();
+    void linksInserted(const QModelIndex &parent, int first, int last);
+
+private:
+    struct Group {
+        Group() : sum(0.0), count(0) {}
+        qreal sum;
+        int count;
+        QMap<qreal, int> values;    // only kept for opMax
+    };
+
+    struct Rollup {
+        QString title;
+        ObjectListModel *members;
+        ObjectListModel *links;
+        std::string groupRef;
+        std::string memberRef;
+        QString property;
+        bool rate;
+        Op op;
+
+        QHash<QString, qreal> current;              // member -> value
+        QHash<QString, QStringList> memberGroups;   // member -> the groups it is in
+        QHash<QString, Group> groups;
+        // link name -> group and member, and the number of links between them
+        QHash<QString, QPair<QString, QString> > linkPairs;
+        QHash<QPair<QString, QString>, int> pairLinks;
+    };
+    QList<Rollup *> rollups;
+    QList<ObjectListModel *> sampledModels;
+    QList<ObjectListModel *> watchedModels;
+    QList<ObjectListModel *> linkModels;
+
+    int add(Rollup *rollup);
+    void watch(ObjectListModel *model);
+    void addLinks(Rollup *rollup, int first, int last);
+    void update(Rollup *rollup, const QString &member, qreal value);
+    void remove(Rollup *rollup, const QString &member);
+    void join(Rollup *rollup, const QString &group, const QString &member);
+    void leave(Rollup *rollup, const QString &group, const QString &member);
+    static void addValue(Rollup *rollup, Group &group, qreal value);
+    static void removeValue(Rollup *rollup, Group &group, qreal value);
+};
+
+#endif // TOPOLOGYAGGREGATOR_H
@@ -0,0 +1,257 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "topology-snapshot.h"
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QDateTime>
+#include <QSettings>
+#include <QDesktopServices>
+#include <QCryptographicHash>
+#include <qmf/Schema.h>
+#include <qmf/DataAddr.h>
+#include <qpid/types/Uuid.h>
+
+static const quint32 snapshotMagic = 0x58565431;    // "XVT1"
+
+// qpid Variants are written as a type byte followed by the value
+static void writeVariant(QDataStream &out, const qpid::types::Variant &v);
+
+static void writeMap(QDataStream &out, const qpid::types::Variant::Map &map)
+{
+    out << (quint32)map.size();
+    qpid::types::Variant::Map::const_iterator iter = map.begin();
+    while (iter != map.end()) {
+        out << QByteArray(iter->first.data(), iter->first.size());
+        writeVariant(out, iter->second);
+        ++iter;
+    }
+}
+
+static void writeVariant(QDataStream &out, const qpid::types::Variant &v)
+{
+    out << (quint8)v.getType();
+    switch (v.getType()) {
+    case qpid::types::VAR_BOOL:   out << (quint8)v.asBool(); break;
+    case qpid::types::VAR_UINT8:  out << v.asUint8(); break;
+    case qpid::types::VAR_UINT16: out << v.asUint16(); break;
+    case qpid::types::VAR_UINT32: out << v.asUint32(); break;
+    case qpid::types::VAR_UINT64: out << (quint64)v.asUint64(); break;
+    case qpid::types::VAR_INT8:   out << v.asInt8(); break;
+    case qpid::types::VAR_INT16:  out << v.asInt16(); break;
+    case qpid::types::VAR_INT32:  out << v.asInt32(); break;
+    case qpid::types::VAR_INT64:  out << (qint64)v.asInt64(); break;
+    case qpid::types::VAR_FLOAT:  out << v.asFloat(); break;
+    case qpid::types::VAR_DOUBLE: out << v.asDouble(); break;
+    case qpid::types::VAR_STRING: {
+        const std::string &s = v.getString();
+        out << QByteArray(s.data(), s.size()) << QByteArray(v.getEncoding().c_str());
+        break;
+    }
+    case qpid::types::VAR_MAP:
+        writeMap(out, v.asMap());
+        break;
+    case qpid::types::VAR_LIST: {
+        const qpid::types::Variant::List &list = v.asList();
+        out << (quint32)list.size();
+        qpid::types::Variant::List::const_iterator iter = list.begin();
+        while (iter != list.end()) {
+            writeVariant(out, *iter);
+            ++iter;
+        }
+        break;
+    }
+    case qpid::types::VAR_UUID:
+        out << QByteArray((const char *)v.asUuid().data(), qpid::types::Uuid::SIZE);
+        break;
+    default:
+        break;
+    }
+}
+
+static qpid::types::Variant readVariant(QDataStream &in);
+
+static qpid::types::Variant::Map readMap(QDataStream &in)
+{
+    qpid::types::Variant::Map map;
+    quint32 count;
+    in >> count;
+    for (quint32 i=0; i<count && in.status() == QDataStream::Ok; ++i) {
+        QByteArray key;
+        in >> key;
+        map[std::string(key.constData(), key.size())] = readVariant(in);
+    }
+    return map;
+}
+
+static qpid::types::Variant readVariant(QDataStream &in)
+{
+    quint8 type;
+    in >> type;
+    switch (type) {
+    case qpid::types::VAR_BOOL:   { quint8 b; in >> b; return qpid::types::Variant(b != 0); }
+    case qpid::types::VAR_UINT8:  { quint8 n; in >> n; return qpid::types::Variant((uint8_t)n); }
+    case qpid::types::VAR_UINT16: { quint16 n; in >> n; return qpid::types::Variant((uint16_t)n); }
+    case qpid::types::VAR_UINT32: { quint32 n; in >> n; return qpid::types::Variant((uint32_t)n); }
+    case qpid::types::VAR_UINT64: { quint64 n; in >> n; return qpid::types::Variant((uint64_t)n); }
+    case qpid::types::VAR_INT8:   { qint8 n; in >> n; return qpid::types::Variant((int8_t)n); }
+    case qpid::types::VAR_INT16:  { qint16 n; in >> n; return qpid::types::Variant((int16_t)n); }
+    case qpid::types::VAR_INT32:  { qint32 n; in >> n; return qpid::types::Variant((int32_t)n); }
+    case qpid::types::VAR_INT64:  { qint64 n; in >> n; return qpid::types::Variant((int64_t)n); }
+    case qpid::types::VAR_FLOAT:  { float n; in >> n; return qpid::types::Variant(n); }
+    case qpid::types::VAR_DOUBLE: { double n; in >> n; return qpid::types::Variant(n); }
+    case qpid::types::VAR_STRING: {
+        QByteArray s, encoding;
+        in >> s >> encoding;
+        qpid::types::Variant v(std::string(s.constData(), s.size()));
+        if (!encoding.isEmpty())
+            v.setEncoding(encoding.constData());
+        return v;
+    }
+    case qpid::types::VAR_MAP:
+        return qpid::types::Variant(readMap(in));
+    case qpid::types::VAR_LIST: {
+        qpid::types::Variant::List list;
+        quint32 count;
+        in >> count;
+        for (quint32 i=0; i<count && in.status() == QDataStream::Ok; ++i)
+            list.push_back(readVariant(in));
+        return qpid::types::Variant(list);
+    }
+    case qpid::types::VAR_UUID: {
+        QByteArray bytes;
+        in >> bytes;
+        if (bytes.size() == (int)qpid::types::Uuid::SIZE)
+            return qpid::types::Variant(qpid::types::Uuid((const unsigned char *)bytes.constData()));
+        return qpid::types::Variant();
+    }
+    default:
+        return qpid::types::Variant();
+    }
+}
+
+TopologySnapshot::TopologySnapshot()
+{
+}
+
+void TopologySnapshot::addModel(const QString &qmfClass, ObjectListModel *model)
+{
+    classes.append(qmfClass);
+    models.append(model);
+}
+
+// one file per broker url, in the application's data directory
+QString TopologySnapshot::fileFor(const QString &url)
+{
+    return QDesktopServices::storageLocation(QDesktopServices::DataLocation) + "/snapshots/" + brokerKey(url) + ".snap";
+}
+
+QString TopologySnapshot::brokerKey(const QString &url)
+{
+    return QString(QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Md5).toHex());
+}
+
+bool TopologySnapshot::save(const QString &url)
+{
+    QString path = fileFor(url);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // write to a temporary file so a crash can't leave half a snapshot
+    QFile file(path + ".tmp");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    int total = 0;
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << snapshotMagic << (quint32)classes.size();
+    for (int i=0; i<classes.size(); ++i) {
+        ObjectListModel *model = models.at(i);
+        int rows = model->rowCount();
+        out << classes.at(i) << (quint32)rows;
+        for (int row=0; row<rows; ++row) {
+            const qmf::Data &object = model->qmfData(row);
+            writeMap(out, object.getAddr().asMap());
+            writeMap(out, object.getProperties());
+        }
+        total += rows;
+    }
+    file.close();
+    if (out.status() != QDataStream::Ok) {
+        file.remove();
+        return false;
+    }
+    QFile::remove(path);
+    if (!file.rename(path))
+        return false;
+
+    // remember which broker each snapshot belongs to, next to the window state
+    QSettings settings;
+    settings.beginGroup("snapshots");
+    settings.setValue(QFileInfo(path).baseName(),
+                      QStringList() << url << QDateTime::currentDateTime().toString(Qt::ISODate) << QString::number(total));
+    settings.endGroup();
+    return true;
+}
+
+int TopologySnapshot::load(const QString &url)
+{
+    QFile file(fileFor(url));
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+    uchar *map = file.map(0, file.size());
+    if (!map)
+        return 0;
+
+    // read straight out of the mapping without copying the file
+    QByteArray bytes = QByteArray::fromRawData((const char *)map, file.size());
+    QDataStream in(bytes);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic, classCount;
+    in >> magic >> classCount;
+    if (magic != snapshotMagic)
+        return 0;
+
+    int total = 0;
+    for (quint32 c=0; c<classCount && in.status() == QDataStream::Ok; ++c) {
+        QString qmfClass;
+        quint32 count;
+        in >> qmfClass >> count;
+        int index = classes.indexOf(qmfClass);
+
+        QList<qmf::Data> objects;
+        qmf::Schema schema(qmf::SCHEMA_TYPE_DATA, "org.apache.qpid.broker", qmfClass.toStdString());
+        for (quint32 i=0; i<count && in.status() == QDataStream::Ok; ++i) {
+            qpid::types::Variant::Map addr = readMap(in);
+            qpid::types::Variant::Map props = readMap(in);
+            if (index < 0)
+                continue;
+            qmf::Data object(schema);
+            object.overwriteProperties(props);
+            object.setAddr(qmf::DataAddr(addr));
+            objects.append(object);
+        }
+        if (index >= 0 && in.status() == QDataStream::Ok)
+            total += models.at(index)->loadObjects(objects);
+    }
+    return total;
+}
@@ -0,0 +1,52 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef TOPOLOGYSNAPSHOT_H
+#define TOPOLOGYSNAPSHOT_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include "object-model.h"
+
+// Saves the objects of each model for a broker so the next connection to
+// the same broker can show them before the first queries complete.
+// The snapshot is read through a memory map. The first full query of each
+// class then replaces or removes the snapshot's objects.
+class TopologySnapshot
+{
+public:
+    TopologySnapshot();
+
+    void addModel(const QString &qmfClass, ObjectListModel *model);
+
+    bool save(const QString &url);
+    // returns the number of objects loaded
+    int load(const QString &url);
+
+    static QString fileFor(const QString &url);
+    // a file name safe key for a broker url
+    static QString brokerKey(const QString &url);
+
+private:
+    QStringList classes;
+    QList<ObjectListModel *> models;
+};
+
+#endif // TOPOLOGYSNAPSHOT_H
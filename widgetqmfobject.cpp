@@ -19,9 +19,12 @@
 
 #include "widgetqmfobject.h"
 #include "ui_widgetqmfobject.h"
+#include "diagnostics.h"
 #include <QPainter>
 #include <QGraphicsDropShadowEffect>
 #include <QResizeEvent>
+#include <QSettings>
+#include <algorithm>
 
 const QColor WidgetQmfObject::colors[] = {
         QColor(255, 255, 220), // yellow  (messages)
@@ -34,6 +37,7 @@ WidgetQmfObject::WidgetQmfObject(QWidget *parent) :
     peers(),
     leftBuddy(),
     rightBuddy(),
+    followers(),
     sectionTitle(),
     backgroundColor(200, 200, 200),
     currentMode(modeMessages),
@@ -46,24 +50,33 @@ WidgetQmfObject::WidgetQmfObject(QWidget *parent) :
     _arrow(arrowNone),
     ui(new Ui::WidgetQmfObject),
     duration(600),
+    viewMSecs(0),
     redIcon(":/images/legend-red.png"),
     greenIcon(":/images/legend-green.png"),
     blueIcon(":/images/legend-blue.png"),
     drawAsRect(false),
     propertyDelegate(),
-    relatedHeader()
+    relatedHeader(),
+    popupDirty(true),
+    summaryModel(),
+    _occluded(false),
+    stale(false),
+    relatedPending(false),
+    pendingArrow(arrowNone)
 {
     ui->setupUi(this);
 
+    summaryModel = new SummaryModel(this);
+    ui->tableSummary->setModel(summaryModel);
+
     ui->commandLinkButtonPrev->setIconType(QStyle::SP_ArrowLeft);
     ui->commandLinkButtonNext->setIconType(QStyle::SP_ArrowRight);
 
-    ui->tableWidget->setColumnCount(2);
     QGraphicsDropShadowEffect* shadow = new QGraphicsDropShadowEffect();
     shadow->setBlurRadius(4);
     shadow->setColor(QColor(200, 200, 200, 180));
     shadow->setOffset(4);
-    ui->tableWidget->setGraphicsEffect(shadow);
+    ui->tableSummary->setGraphicsEffect(shadow);
 
     setFocusPolicy(Qt::StrongFocus);
     ui->comboBox->hide();
@@ -72,6 +85,7 @@ WidgetQmfObject::WidgetQmfObject(QWidget *parent) :
 
     ui->toolButton->hide();
     connect(ui->toolButton, SIGNAL(clicked()), this, SLOT(pivot()));
+    connect(ui->widgetChart, SIGNAL(compareModeChanged()), this, SLOT(compareModeChanged()));
 }
 
 WidgetQmfObject::~WidgetQmfObject()
@@ -111,10 +125,11 @@ void WidgetQmfObject::setRelatedModel(ObjectListModel *model, QWidget *parent)
     // the related model filters the main model down to just
     // those object that are related
     related = new RelatedFilterProxyModel(parent);
-    related->setDynamicSortFilter(false);
     related->setSourceModel(model);
 
     // the comboBox uses the related model
+    // Don't let it size itself to its contents, that would look at every row
+    ui->comboBox->setSizeAdjustPolicy(QComboBox::AdjustToMinimumContentsLength);
     ui->comboBox->setModel(related);
     connect(ui->comboBox, SIGNAL(activated(int)),
             this, SLOT(relatedIndexChanged(int)));
@@ -122,21 +137,24 @@ void WidgetQmfObject::setRelatedModel(ObjectListModel *model, QWidget *parent)
     // the samples kept by the main model should only live this long
     model->setDuration(duration);
 
-    // For the related popup table, draw the columns with custom pixmaps
-    // instead of text values
-    propertyDelegate = new PropertyDelegate(this, getSampleProperties());
-    ui->tableView->setItemDelegate(propertyDelegate);
+    // the model computes the derived columns as each object arrives,
+    // and the rates of each column as its kind says
+    QList<Column>::const_iterator column = summaryColumns.constBegin();
+    while (column != summaryColumns.constEnd()) {
+        if ((*column).expression.isValid())
+            model->addDerived(QString((*column).name.c_str()), (*column).expression);
+        if ((*column).kind == kindCounter || (*column).kind == kindGauge)
+            model->setCounter(QString((*column).name.c_str()), (*column).kind == kindCounter);
+        ++column;
+    }
 
+    // The popup table's delegate and header are created the first time
+    // the popup is shown
+    ui->tableView->installEventFilter(this);
 
-    // For the related popup table, draw the column headers with custom icons
-    relatedHeader = new RelatedHeaderView(Qt::Horizontal, ui->tableView);
-    relatedHeader->setSortIndicatorShown(false);
-    relatedHeader->setStretchLastSection(false);
-    relatedHeader->setCascadingSectionResizes(false);
-    relatedHeader->setClickable(true);
-    relatedHeader->setMovable(false);
-    relatedHeader->setAllColumns(getSampleProperties());
-    ui->tableView->setHorizontalHeader(relatedHeader);
+    // All rows are the same height, so the popup only measures and paints
+    // the rows that are visible, and fetches more as it is scrolled
+    ui->tableView->verticalHeader()->setResizeMode(QHeaderView::Fixed);
 
     // For the related combobox, show a custom table instead of the default list
     ui->comboBox->setView(ui->tableView);
@@ -185,7 +203,7 @@ void WidgetQmfObject::resizeEvent(QResizeEvent *)
     } else {
         ui->comboBox->move(0, reservedY());
     }
-    ui->tableWidget->move(width() / 2 - ui->tableWidget->width() / 2, ui->comboBox->y() + ui->comboBox->height() + 46);
+    ui->tableSummary->move(width() / 2 - ui->tableSummary->width() / 2, ui->comboBox->y() + ui->comboBox->height() + 46);
     ui->labelName->resize(width(), ui->labelName->height());
     ui->comboBox->resize(width(), ui->comboBox->height());
 
@@ -201,7 +219,7 @@ void WidgetQmfObject::resizeEvent(QResizeEvent *)
     if (chart) {
         ui->widgetChart->resize(width() - 20, ui->widgetChart->height());
         ui->widgetChart->move(width() / 2 - ui->widgetChart->width() / 2, ui->comboBox->y() + ui->comboBox->height() + 46);
-        ui->tableWidget->move(width() / 2 - ui->tableWidget->width() / 2, ui->widgetChart->y() + ui->widgetChart->height() + 6);
+        ui->tableSummary->move(width() / 2 - ui->tableSummary->width() / 2, ui->widgetChart->y() + ui->widgetChart->height() + 6);
     }
 }
 
@@ -336,6 +354,51 @@ void WidgetQmfObject::setCurrent(bool _c)
     update();
 }
 
+// Called by the layout when this section becomes mostly hidden or visible.
+// Work that was skipped while hidden is done when the section shows again
+void WidgetQmfObject::setOccluded(bool occluded)
+{
+    if (_occluded == occluded)
+        return;
+    _occluded = occluded;
+    if (_occluded)
+        return;
+
+    if (relatedPending) {
+        relatedPending = false;
+        showRelated(pendingObject, pendingType, pendingArrow);
+    }
+    if (stale) {
+        stale = false;
+        fillSummaryTable();
+        if (chart && data.isValid())
+            showChart(data, (ObjectListModel *)related->sourceModel());
+    }
+}
+
+// Show the objects as they were at a wall clock time, 0 for live.
+// The caller refreshes the current section afterwards, which carries the
+// time over to the related sections
+void WidgetQmfObject::setViewTime(qint64 msecs)
+{
+    viewMSecs = msecs;
+    related->setViewTime(msecs);
+    ui->widgetChart->setViewTime(msecs);
+}
+
+// Is there a visible section further along in direction a that
+// depends on this section's related object
+bool WidgetQmfObject::neededDownstream(ArrowDirection a)
+{
+    WidgetQmfObject *buddy = (a == arrowLeft) ? leftBuddy : (a == arrowRight ? rightBuddy : 0);
+    while (buddy) {
+        if (!buddy->occluded())
+            return true;
+        buddy = (a == arrowLeft) ? buddy->leftBuddy : buddy->rightBuddy;
+    }
+    return false;
+}
+
 bool WidgetQmfObject::current()
 {
     return _current;
@@ -375,13 +438,23 @@ void WidgetQmfObject::setLabelName()
     QFontMetrics label_fm(ui->labelName->font());
     QString elided_text = label_fm.elidedText(full_text, Qt::ElideRight, ui->labelName->width());
     ui->labelName->setText(elided_text);
-    ui->labelName->setToolTip(full_text);
+
+    // highlight an object whose metrics are out of the ordinary
+    ObjectListModel *model = (ObjectListModel *)related->sourceModel();
+    bool flagged = model && data.isValid() && model->flagged(unique_property());
+    if (flagged) {
+        ui->labelName->setStyleSheet("QLabel { background-color: rgb(255, 200, 200); }");
+        ui->labelName->setToolTip(full_text + tr("\nUnusual activity"));
+    } else {
+        ui->labelName->setStyleSheet(QString());
+        ui->labelName->setToolTip(full_text);
+    }
 }
 
 void WidgetQmfObject::reset()
 {
     this->setCurrent(false);
-    ui->tableWidget->hide();
+    ui->tableSummary->hide();
     ui->labelName->hide();
     ui->labelRelated->hide();
     ui->labelIndex->hide();
@@ -393,12 +466,15 @@ void WidgetQmfObject::reset()
     //ui->comboBox->clear();
     _arrow = arrowNone;
     ui->widgetChart->clear();
+    relatedPending = false;
+    stale = false;
 }
 
 void WidgetQmfObject::setCurrentMode(StatMode mode)
 {
     currentMode = mode;
-    fillTableWidget();
+    popupDirty = true;
+    fillSummaryTable();
     if (chart) {
         if (data.isValid()) {
             ObjectListModel *model = (ObjectListModel *)related->sourceModel();
@@ -480,11 +556,10 @@ void WidgetQmfObject::showData(const qmf::Data& object)
         return;
 
     ui->labelName->show();
-    ui->tableWidget->show();
-    ui->tableWidget->setRowCount(summaryColumns.size());
+    ui->tableSummary->show();
 
     data = object;
-    fillTableWidget();
+    fillSummaryTable();
 
     if (leftBuddy) {
         leftBuddy->showRelated(object, objectName(), arrowLeft);
@@ -492,6 +567,11 @@ void WidgetQmfObject::showData(const qmf::Data& object)
     if (rightBuddy) {
         rightBuddy->showRelated(object, objectName(), arrowRight);
     }
+    QList<WidgetQmfObject *>::const_iterator follower = followers.constBegin();
+    while (follower != followers.constEnd()) {
+        (*follower)->showRelated(object, objectName(), arrowRight);
+        ++follower;
+    }
     if (chart) {
         ObjectListModel *model = (ObjectListModel *)related->sourceModel();
         showChart(object, model);
@@ -513,128 +593,181 @@ void WidgetQmfObject::resetOthers()
     }
 }
 
-void WidgetQmfObject::fillTableWidget()
+// Update the summary table with the current object's values
+// The table's geometry is only recalculated when its rows change
+void WidgetQmfObject::fillSummaryTable()
 {
     if (!data.isValid())
         return;
+    if (_occluded) {
+        stale = true;
+        return;
+    }
+    Diagnostics::Timer timer("gui: summary table");
 
     setLabelName();
 
-    if (chart)
-        ui->tableWidget->setColumnCount(3);
-    else
-        ui->tableWidget->setColumnCount(2);
-
-    QTableWidgetItem *newItem;
-    int row = 0;
-    int maxValWidth = 0;
-    int maxNameWidth = 0;
-    int maxModeWidth = 0;
-    QFontMetrics fm(ui->tableWidget->font());
-
     const qpid::types::Variant::Map& props(data.getProperties());
     qpid::types::Variant::Map::const_iterator iter;
+    QString uname = unique_property();
 
-    QList<Column>::const_iterator column_iter = summaryColumns.constBegin();
+    // when looking at the past, the sampled values come from the sample at that time
+    Sample pastSample;
+    const Sample *past = 0;
+    if (viewMSecs) {
+        ObjectListModel *model = (ObjectListModel *)related->sourceModel();
+        if (model->sampleAt(uname, viewMSecs, pastSample))
+            past = &pastSample;
+    }
 
-    // remove and free up any existing table cells
-    ui->tableWidget->clearContents();
+    QList<SummaryModel::Row> rows;
+    QList<Column>::const_iterator column_iter = summaryColumns.constBegin();
 
-    int col; // which column we are creating
     // loop through all the columns we might want to display
     while (column_iter != summaryColumns.constEnd()) {
         // find the column in the current data
         iter = props.find((*column_iter).name);
         bool show = (*column_iter).mode == currentMode;
         if ((iter != props.end()) && show) {
-            col = 0;
-
-            if (chart) {
-
-                newItem = new QTableWidgetItem("");
-                newItem->setBackgroundColor(colors[currentMode]);
-                if ((*column_iter).chart) {
-                    if ((*column_iter).color == QColor(Qt::red))
-                        newItem->setIcon(redIcon);
-                    else if ((*column_iter).color == QColor(Qt::green))
-                        newItem->setIcon(greenIcon);
-                    else if ((*column_iter).color == QColor(Qt::blue))
-                        newItem->setIcon(blueIcon);
-                }
-                ui->tableWidget->setItem(row, col++, newItem);
+            SummaryModel::Row row;
+            row.value = value(iter, uname, (*column_iter).format, past);
+            row.header = (*column_iter).header;
+            row.alignment = (*column_iter).alignment;
+            if (chart && (*column_iter).chart) {
+                if ((*column_iter).color == QColor(Qt::red))
+                    row.icon = redIcon;
+                else if ((*column_iter).color == QColor(Qt::green))
+                    row.icon = greenIcon;
+                else if ((*column_iter).color == QColor(Qt::blue))
+                    row.icon = blueIcon;
             }
+            rows.append(row);
+        }
+        ++column_iter;
+    }
 
-            newItem = new QTableWidgetItem(value(iter, unique_property(), (*column_iter).format));
-            newItem->setBackgroundColor(colors[currentMode]);
-            newItem->setTextAlignment((*column_iter).alignment);
-            maxValWidth = qMax(maxValWidth, fm.width(newItem->text()));
-            ui->tableWidget->setItem(row, col++, newItem);
+    derivedRows(rows);
 
-            newItem = new QTableWidgetItem((*column_iter).header);
-            newItem->setBackgroundColor(colors[currentMode]);;
-            maxNameWidth = qMax(maxNameWidth, fm.width(newItem->text()));
-            ui->tableWidget->setItem(row, col++, newItem);
+    QList<int> changed;
+    if (summaryModel->setRows(rows, chart, colors[currentMode], &changed)) {
+        resizeSummaryTable();
+        return;
+    }
 
-            ++row;
+    // only values changed. Widen the table if a new value no longer fits
+    QFontMetrics fm(ui->tableSummary->font());
+    int valueWidth = ui->tableSummary->columnWidth(summaryModel->valueColumn());
+    QList<int>::const_iterator iChanged = changed.constBegin();
+    while (iChanged != changed.constEnd()) {
+        if (fm.width(summaryModel->row(*iChanged).value) + 8 > valueWidth) {
+            resizeSummaryTable();
+            break;
         }
-        ++column_iter;
+        ++iChanged;
+    }
+}
+
+void WidgetQmfObject::addRollup(TopologyAggregator *aggregator, int rollup, StatMode mode)
+{
+    RollupRow row;
+    row.aggregator = aggregator;
+    row.rollup = rollup;
+    row.mode = mode;
+    rollupRows.append(row);
+}
+
+// The rollups for this object in the current mode. They are running totals
+// of the latest samples, so there are none for a past time
+void WidgetQmfObject::derivedRows(QList<SummaryModel::Row>& rows)
+{
+    if (viewMSecs)
+        return;
+
+    QString uname = unique_property();
+    QList<RollupRow>::const_iterator iter = rollupRows.constBegin();
+    while (iter != rollupRows.constEnd()) {
+        const RollupRow& rollup = *iter;
+        ++iter;
+        if (rollup.mode != currentMode)
+            continue;
+
+        SummaryModel::Row row;
+        qreal total;
+        if (!rollup.aggregator->value(rollup.rollup, uname, total))
+            row.value = QString("--");
+        else if (rollup.aggregator->isRate(rollup.rollup))
+            row.value.setNum((float)total);
+        else
+            row.value = QString::number((qint64)total);
+        row.header = rollup.aggregator->title(rollup.rollup);
+        row.alignment = Qt::AlignRight;
+        rows.append(row);
     }
-    ui->tableWidget->resize((chart ? 16 : 0) + maxModeWidth + maxValWidth + maxNameWidth + 20, fm.height() * row - row/2 - row/7);
-    col = 0;
+}
+
+// Size the summary table to fit its contents
+void WidgetQmfObject::resizeSummaryTable()
+{
+    int maxValWidth = 0;
+    int maxNameWidth = 0;
+    QFontMetrics fm(ui->tableSummary->font());
+
+    int row = summaryModel->rowCount();
+    for (int i=0; i<row; ++i) {
+        maxValWidth = qMax(maxValWidth, fm.width(summaryModel->row(i).value));
+        maxNameWidth = qMax(maxNameWidth, fm.width(summaryModel->row(i).header));
+    }
+
+    ui->tableSummary->resize((chart ? 16 : 0) + maxValWidth + maxNameWidth + 20, fm.height() * row - row/2 - row/7);
+    int col = 0;
     if (chart)
-        ui->tableWidget->setColumnWidth(col++, 18);
-    ui->tableWidget->setColumnWidth(col++, maxValWidth + 8);
-    ui->tableWidget->setColumnWidth(col, maxNameWidth + 8);
+        ui->tableSummary->setColumnWidth(col++, 18);
+    ui->tableSummary->setColumnWidth(col++, maxValWidth + 8);
+    ui->tableSummary->setColumnWidth(col, maxNameWidth + 8);
 
     // force a resize event so the table is drawn in the correct place
     QResizeEvent event(size(), size());
     QApplication::sendEvent(this, &event);
-
 }
 
-// Generate the value to display in the tableWidget
-QString WidgetQmfObject::value(const qpid::types::Variant::Map::const_iterator& iter, const QString& uname, const std::string & format)
+// Generate the value to display in the summary table
+QString WidgetQmfObject::value(const qpid::types::Variant::Map::const_iterator& iter, const QString& uname, const std::string & format, const Sample *past)
 {
     QString val = QString("--");
+    ObjectListModel *pModel = (ObjectListModel *)related->sourceModel();
+    QString property(iter->first.c_str());
+    bool sampled = viewMSecs && pModel->sampled().contains(property);
+
     // if we aren't showing a rate, return the value directly
     if ((currentMode == this->modeMessages) || (currentMode == this->modeBytes)) {
+        if (sampled) {
+            // nothing was recorded for this object at that time
+            if (!past)
+                return val;
+            qpid::types::Variant v((int64_t)past->data(property));
+            return format == "B" ? fmtBytes(v) : QString(v.asString().c_str());
+        }
         if (format == "B")
             return fmtBytes(iter->second);
         else
             return QString(iter->second.asString().c_str());
     }
 
-    // we are showing a rate. get the two most recent values
-    ObjectListModel *pModel = (ObjectListModel *)related->sourceModel();
-    ObjectListModel::Samples samples = pModel->samples();
+    if (viewMSecs) {
+        if (past && past->hasRate(property))
+            val.setNum((float)past->rate(property).value(pModel->getRateWindow()));
+        return val;
+    }
+
+    // we are showing a rate. The model computed it when the last sample arrived
+    const ObjectListModel::Samples& samples = pModel->samples();
 
     // get the sample's hash entry for this object
     ObjectListModel::const_iterSamples iterSamples = samples.constFind(uname);
-    if (iterSamples != samples.constEnd()) {
-        // get the list of samples
-        ObjectListModel::SampleList sampleList = iterSamples.value();
-        // get the last (most recent) sample from the list
-        ObjectListModel::const_iterSampleList iList = sampleList.constEnd();
-        // skip the place holder "end"
-        --iList;
-        if (iList != sampleList.constBegin()) {
-            Sample sample1 = *iList;
-            // if there is another sample
-            --iList;
-            if (iList != sampleList.constBegin()) {
-                // get the previous sample
-                Sample sample2 = *iList;
-                // calculate the change / second
-                int elapsedSecs = sample2.dateTime().secsTo(sample1.dateTime());
-                if (elapsedSecs > 0) {
-                    quint64 val1 = sample1.data(iter->first);
-                    quint64 val2 = sample2.data(iter->first);
-                    quint64 delta = val1 - val2;
-                    float rate = delta / elapsedSecs;
-                    val.setNum(rate);
-                }
-            }
-        }
+    if (iterSamples != samples.constEnd() && !iterSamples.value().isEmpty()) {
+        const Sample& sample = iterSamples.value().last();
+        if (sample.hasRate(property))
+            val.setNum((float)sample.rate(property).value(pModel->getRateWindow()));
     }
     return val;
 }
@@ -711,6 +844,16 @@ void WidgetQmfObject::initRelatedButtons()
 // then send a request to query for all of the objects
 void WidgetQmfObject::showRelated(const qmf::Data& object, const QString &widget_type, ArrowDirection a)
 {
+    // nobody can see the result, remember the request for when we are visible
+    if (_occluded && !neededDownstream(a)) {
+        pendingObject = object;
+        pendingType = widget_type;
+        pendingArrow = a;
+        relatedPending = true;
+        return;
+    }
+    relatedPending = false;
+
     if (!updateAll)
         if (hasData() && (arrow() != arrowNone)) {
             //qDebug("showRelated: %s needs an update", this->objectName().toStdString().c_str());
@@ -770,6 +913,37 @@ void WidgetQmfObject::initRelated()
         updateComboboxIndex(ui->comboBox->currentIndex(), false);
     }
 
+    // the min/max values are only gathered when the popup is visible
+    popupDirty = true;
+    if (ui->tableView->isVisible())
+        preparePopup();
+}
+
+// Create the related popup table's delegate and header if needed and
+// refresh the column info they draw with
+void WidgetQmfObject::preparePopup()
+{
+    if (!propertyDelegate) {
+        // For the related popup table, draw the columns with custom pixmaps
+        // instead of text values
+        propertyDelegate = new PropertyDelegate(this, getSampleProperties());
+        ui->tableView->setItemDelegate(propertyDelegate);
+
+        // For the related popup table, draw the column headers with custom icons
+        relatedHeader = new RelatedHeaderView(Qt::Horizontal, ui->tableView);
+        relatedHeader->setSortIndicatorShown(false);
+        relatedHeader->setStretchLastSection(false);
+        relatedHeader->setCascadingSectionResizes(false);
+        relatedHeader->setClickable(true);
+        relatedHeader->setMovable(false);
+        relatedHeader->setAllColumns(getSampleProperties());
+        ui->tableView->setHorizontalHeader(relatedHeader);
+        popupDirty = true;
+    }
+    if (!popupDirty)
+        return;
+    popupDirty = false;
+
     relatedHeader->moveNameColumn();
 
     // Tell the property delegate for the related popup table
@@ -804,6 +978,14 @@ void WidgetQmfObject::initRelated()
     relatedHeader->setResizeMode(0, QHeaderView::Stretch);
 }
 
+// The related popup is about to be drawn, make sure its columns are current
+bool WidgetQmfObject::eventFilter(QObject *object, QEvent *event)
+{
+    if (object == ui->tableView && event->type() == QEvent::Show)
+        preparePopup();
+    return QWidget::eventFilter(object, event);
+}
+
 // SLOT called when the current row in the ui->comboBox changes
 void WidgetQmfObject::relatedIndexChanged(int i)
 {
@@ -822,7 +1004,7 @@ void WidgetQmfObject::updateComboboxIndex(int i, bool all)
         ui->widgetChart->clear();
         ui->widgetChart->hide();
         ui->comboBox->hide();
-        ui->tableWidget->hide();
+        ui->tableSummary->hide();
         ui->toolButton->hide();
 
         // If this widget has no related objects, all the other widgets to the side won't either
@@ -840,17 +1022,19 @@ void WidgetQmfObject::updateComboboxIndex(int i, bool all)
            }
            return;
     }
-    int rows = ui->comboBox->model()->rowCount();
+    int rows = related->rowCount();
+    // there may be more related objects that haven't been looked at yet
+    QString more = related->canFetchMore(QModelIndex()) ? "+" : "";
 
     // in case the user clicked on a numeric column in the popup tableview
     // reset the text shown in the combobox to the 1st column
     ui->comboBox->setCurrentIndex(i);
 
     ui->comboBox->show();
-    QString indexText = QString("%1 of %2 %3").arg(i+1).arg(rows).arg(ui->labelRelated->text().toLower());
+    QString indexText = QString("%1 of %2%3 %4").arg(i+1).arg(rows).arg(more).arg(ui->labelRelated->text().toLower());
     ui->labelIndex->setText(indexText);
     ui->labelIndex->show();
-    ui->tableWidget->show();
+    ui->tableSummary->show();
     ui->toolButton->show();
 
     // get the data object that the selected row in the combo box referrs to
@@ -859,8 +1043,7 @@ void WidgetQmfObject::updateComboboxIndex(int i, bool all)
     data = model->qmfData(source_row.row());
 
     // show the current stats for this object
-    ui->tableWidget->setRowCount(summaryColumns.size());
-    fillTableWidget();
+    fillSummaryTable();
 
     if (chart)
         showChart(data, model);
@@ -903,7 +1086,7 @@ void WidgetQmfObject::showChart(bool b)
         if (data.isValid()) {
             ObjectListModel *model = (ObjectListModel *)related->sourceModel();
             ui->widgetChart->show();
-            fillTableWidget();
+            fillSummaryTable();
             showChart(data, model);
         }
     } else {
@@ -917,6 +1100,11 @@ void WidgetQmfObject::showChart(bool b)
 
 void WidgetQmfObject::showChart(const qmf::Data&, ObjectListModel *model)
 {
+    if (_occluded) {
+        stale = true;
+        return;
+    }
+
     //
     // show the chart for this object
     //
@@ -939,17 +1127,173 @@ void WidgetQmfObject::showChart(const qmf::Data&, ObjectListModel *model)
     ui->widgetChart->show();
 
     QString name = unique_property();
+    if (ui->widgetChart->compareMode() != chart::compareNone)
+        ui->widgetChart->setCompared(comparedNames());
     ui->widgetChart->updateChart(isRate, model, name, chartColumns, duration, chartType);
 
 }
 
+// The objects to compare in the chart. The related objects when this section
+// shows objects related to another one. Otherwise the objects selected in the
+// section's dialog, or when fewer than two are selected, all of the section's own.
+// When there are too many to chart, the ones with the largest values are kept
+QStringList WidgetQmfObject::comparedNames()
+{
+    QStringList names;
+    ObjectListModel *model = (ObjectListModel *)related->sourceModel();
+    if (_current) {
+        const QStringList& selected = model->compared();
+        QStringList::const_iterator iter = selected.constBegin();
+        while (iter != selected.constEnd()) {
+            if (model->findRow(*iter) >= 0)
+                names.append(*iter);
+            ++iter;
+        }
+        if (names.isEmpty()) {
+            for (int row=0; row<model->rowCount(); ++row)
+                names.append(model->uniqueName(row));
+        }
+    } else {
+        for (int row=0; row<related->rowCount(); ++row)
+            names.append(model->uniqueName(related->mapToSource(related->index(row, 0)).row()));
+    }
+    if (names.size() <= chart::maxCompared)
+        return names;
+
+    // the chart compares the first of its properties in name order
+    QStringList props;
+    QList<Column>::const_iterator column = summaryColumns.constBegin();
+    while (column != summaryColumns.constEnd()) {
+        if ((*column).mode == currentMode && (*column).chart)
+            props.append(QString((*column).name.c_str()));
+        ++column;
+    }
+    if (props.isEmpty())
+        return names.mid(0, chart::maxCompared);
+    props.sort();
+    const QString& prop = props.first();
+    bool isRate = currentMode == modeMessageRate || currentMode == modeByteRate;
+
+    // rank by each object's latest value
+    const ObjectListModel::Samples& samples = model->samples();
+    QVector<QPair<qreal, QString> > ranked;
+    ranked.reserve(names.size());
+    QStringList::const_iterator iName = names.constBegin();
+    while (iName != names.constEnd()) {
+        qreal value = 0.0;
+        ObjectListModel::const_iterSamples found = samples.constFind(*iName);
+        if (found != samples.constEnd() && !found.value().isEmpty()) {
+            const Sample& sample = found.value().last();
+            if (!isRate)
+                value = sample.data(prop);
+            else if (sample.hasRate(prop))
+                value = sample.rate(prop).value(model->getRateWindow());
+        }
+        ranked.append(qMakePair(-value, *iName));
+        ++iName;
+    }
+    std::partial_sort(ranked.begin(), ranked.begin() + chart::maxCompared, ranked.end());
+
+    QStringList top;
+    for (int i=0; i<chart::maxCompared; ++i)
+        top.append(ranked.at(i).second);
+    return top;
+}
+
+// SLOT triggered when a compare mode is picked from the chart's context menu
+void WidgetQmfObject::compareModeChanged()
+{
+    if (chart && data.isValid())
+        showChart(data, (ObjectListModel *)related->sourceModel());
+}
+
+// Columns are read from an array in the section's group, e.g.
+//   [columns/Queues]
+//   replace=false
+//   column\size=2
+//   column\1\property=acquires
+//   column\1\mode=message rate
+//   column\2\property=avgMsgSize
+//   column\2\header=average message
+//   column\2\expression=byteDepth / msgDepth
+//   column\2\format=B
+// mode is one of messages, bytes, message rate or byte rate. A column with
+// an expression is computed from the object's other properties.
+// kind is counter or gauge, and says whether a drop in the value is a
+// counter reset. Expressions are gauges unless they say otherwise. A text
+// column is shown as it is and isn't sampled.
+void WidgetQmfObject::loadColumns(QSettings& settings)
+{
+    settings.beginGroup(QString("columns/%1").arg(sectionTitle));
+    if (settings.value("replace", false).toBool())
+        summaryColumns.clear();
+
+    int size = settings.beginReadArray("column");
+    for (int i=0; i<size; ++i) {
+        settings.setArrayIndex(i);
+        QString property = settings.value("property").toString();
+        if (property.isEmpty())
+            continue;
+
+        QString modeName = settings.value("mode", "messages").toString();
+        StatMode mode = modeMessages;
+        if (modeName == "bytes")
+            mode = modeBytes;
+        else if (modeName == "message rate")
+            mode = modeMessageRate;
+        else if (modeName == "byte rate")
+            mode = modeByteRate;
+        else if (modeName != "messages") {
+            qWarning("columns/%s: unknown mode '%s' for %s", qPrintable(sectionTitle),
+                     qPrintable(modeName), qPrintable(property));
+            continue;
+        }
+
+        Column column(property.toStdString(), "", Qt::AlignRight,
+                      settings.value("format", "N").toString().toStdString(), mode,
+                      settings.value("chart", false).toBool(),
+                      QColor(settings.value("color", "red").toString()));
+        column.header = settings.value("header", property).toString();
+
+        QString text = settings.value("expression").toString();
+        QString error;
+        if (!text.isEmpty() && !column.expression.compile(text, &error)) {
+            qWarning("columns/%s: %s: %s", qPrintable(sectionTitle), qPrintable(property), qPrintable(error));
+            continue;
+        }
+        // the model evaluates it before any rates are known. Use a rate mode instead
+        if (column.expression.usesRate()) {
+            qWarning("columns/%s: %s: rates can't be used in a column expression",
+                     qPrintable(sectionTitle), qPrintable(property));
+            continue;
+        }
+
+        // a ratio or difference of counters can go down without a reset
+        QString kindName = settings.value("kind", column.expression.isValid() ? "gauge" : "").toString();
+        if (kindName == "counter")
+            column.kind = kindCounter;
+        else if (kindName == "gauge")
+            column.kind = kindGauge;
+        else if (kindName == "text" && !column.expression.isValid())
+            column.kind = kindText;
+        else if (!kindName.isEmpty()) {
+            qWarning("columns/%s: unknown kind '%s' for %s", qPrintable(sectionTitle),
+                     qPrintable(kindName), qPrintable(property));
+            continue;
+        }
+        summaryColumns.append(column);
+    }
+    settings.endArray();
+    settings.endGroup();
+}
+
 QStringList WidgetQmfObject::getSampleProperties()
 {
     QList<QString> cList;
     QList<Column>::const_iterator iter = summaryColumns.constBegin();
     while (iter != summaryColumns.constEnd()) {
         QString col((*iter).name.c_str());
-        if (!cList.contains(col))
+        if ((*iter).kind != kindText && !cList.contains(col))
             cList.append(col);
         ++iter;
     }
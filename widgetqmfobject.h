@@ -23,7 +23,7 @@
 #include <QWidget>
 #include <QPushButton>
 #include <QLabel>
-#include <QTableWidget>
+#include <QTableView>
 #include <QVariant>
 #include "qpid/types/Variant.h"
 #include <qmf/Data.h>
@@ -31,6 +31,11 @@
 #include "object-model.h"
 #include "propertydelegate.h"
 #include "relatedheaderview.h"
+#include "summary-model.h"
+#include "topology-aggregator.h"
+#include "expression.h"
+
+class QSettings;
 
 namespace Ui {
     class WidgetQmfObject;
@@ -53,6 +58,15 @@ public:
         modeMessageRate,
         modeByteRate
     };
+    // what a column's property holds, and so how its rates are computed.
+    // Automatic leaves it to the model, which knows the broker's own gauges.
+    // Text is shown as it is and never sampled
+    enum Kind {
+        kindAutomatic,
+        kindCounter,
+        kindGauge,
+        kindText
+    };
 
     explicit WidgetQmfObject(QWidget *parent = 0);
     ~WidgetQmfObject();
@@ -70,6 +84,9 @@ public:
     void reset();
     void setArrow(ArrowDirection a) {_arrow = a;}
     QStringList getSampleProperties();
+    // add to or replace the summary columns from the settings.
+    // Must be called before the section's model is created
+    void loadColumns(QSettings& settings);
 
     // expose the pushbutton publically so signal/slots can be connected
     QPushButton* pushButton();
@@ -79,9 +96,21 @@ public:
     qmfWidgetList peers;
     WidgetQmfObject *leftBuddy;
     WidgetQmfObject *rightBuddy;
+    // sections showing the objects that refer to this section's current object
+    qmfWidgetList followers;
 
     const qmf::DataAddr& getDataAddr();
     bool hasData();
+    const qmf::Data& currentData() const { return data; }
+
+    void setOccluded(bool occluded);
+    bool occluded() const { return _occluded; }
+
+    // show the values at a past wall clock time instead of the latest ones, 0 for now
+    void setViewTime(qint64 msecs);
+
+    // add a row for the rollup of the objects related to this section's object
+    void addRollup(TopologyAggregator *aggregator, int rollup, StatMode mode);
 
 public slots:
     void setCurrentObject(const qmf::Data& object);
@@ -103,6 +132,7 @@ protected:
     void keyPressEvent ( QKeyEvent * event );
     virtual void showRelated(const qmf::Data& object, const QString& widget_name, ArrowDirection a);
     void showChart(const qmf::Data& object, ObjectListModel *model);
+    bool eventFilter(QObject *object, QEvent *event);
 
 
     int reservedY(); // amount reserved at top of widget for button and label
@@ -113,6 +143,11 @@ protected:
     QColor getLineColor(); // the color to draw the section's background icon (based on focus)
     QColor getFillColor(); // the color to draw the section's background icon (based on focus)
 
+    // rows computed from more than the object's own properties, shown after them
+    virtual void derivedRows(QList<SummaryModel::Row>& rows);
+    // the time being viewed in msecs since the epoch, 0 for now
+    qint64 viewTime() const { return viewMSecs; }
+
     // the columns that are to be displayed in the summary box
     struct Column {
         std::string     name;
@@ -122,9 +157,11 @@ protected:
         StatMode        mode;
         bool            chart;
         QColor          color;
+        Expression      expression; // compiled when the column is derived from others
+        Kind            kind;
 
         Column(const std::string& _n, const char* _h, Qt::Alignment _a, const std::string& _f, StatMode _m, bool _c=false, QColor _co=QColor(Qt::red)):
-            name(_n), header(_h), alignment(_a), format(_f), mode(_m), chart(_c), color(_co) {}
+            name(_n), header(_h), alignment(_a), format(_f), mode(_m), chart(_c), color(_co), expression(), kind(kindAutomatic) {}
     };
     typedef QList<Column> ObjectColumnList;
     ObjectColumnList summaryColumns;
@@ -148,24 +185,28 @@ signals:
 private slots:
     void relatedIndexChanged(int index);
     void pivot(); // make the current related object the base/root object
+    void compareModeChanged();
 
 
 private:
     void setLabelName();
-    void fillTableWidget();
+    void fillSummaryTable();
+    void resizeSummaryTable();
     void resetOthers();
     void updateComboboxIndex(int i, bool all);
     bool reallyHasFocus();
     void showData(const qmf::Data& object);
+    QStringList comparedNames();
     QString fmtBytes(const qpid::types::Variant& v) const;
 
-    QString value(const qpid::types::Variant::Map::const_iterator& iter, const QString& uname, const std::string &);
+    QString value(const qpid::types::Variant::Map::const_iterator& iter, const QString& uname, const std::string &, const Sample *past);
 
     bool _current; // this section is the primary one, others show related objects to this one
     bool chart;     // should we show the chart
     ArrowDirection _arrow;   // direction to draw a background arrow 0->none 1->left 2->right
     Ui::WidgetQmfObject *ui;
     int duration;
+    qint64 viewMSecs;   // the time being viewed, 0 for now
 
     QIcon redIcon;
     QIcon greenIcon;
@@ -174,6 +215,25 @@ private:
 
     PropertyDelegate * propertyDelegate;
     RelatedHeaderView * relatedHeader;
+    bool popupDirty;        // the popup's column info needs recalculating
+    void preparePopup();
+    SummaryModel * summaryModel;
+
+    struct RollupRow {
+        TopologyAggregator *aggregator;
+        int rollup;
+        StatMode mode;
+    };
+    QList<RollupRow> rollupRows;
+
+    // skip queries and painting while the section is hidden by its siblings
+    bool neededDownstream(ArrowDirection a);
+    bool _occluded;
+    bool stale;             // the table and chart need refreshing when visible
+    bool relatedPending;    // a showRelated request was deferred
+    qmf::Data pendingObject;
+    QString pendingType;
+    ArrowDirection pendingArrow;
 
 };
 
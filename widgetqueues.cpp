@@ -21,7 +21,8 @@
 #include <QPainter>
 
 WidgetQueues::WidgetQueues(QWidget *parent) :
-    WidgetQmfObject(parent)
+    WidgetQmfObject(parent),
+    forecast(0)
 {
     this->setSectionName(QString("Queues"));
     summaryColumns.append(Column("msgDepth", "deep", Qt::AlignRight, "N", modeMessages, true));
@@ -84,3 +85,56 @@ void WidgetQueues::showRelated(const qmf::Data& object, const QString &, ArrowDi
     emit needData();
 
 }
+
+// The time until the queue is empty if it is draining, or until it reaches
+// its limit if it is filling, from the trend of its recent depth
+void WidgetQueues::derivedRows(QList<SummaryModel::Row>& rows)
+{
+    WidgetQmfObject::derivedRows(rows);
+    if (!forecast || viewTime())
+        return;
+
+    std::string property;
+    std::string limitArg;
+    if (currentMode == modeMessages) {
+        property = "msgDepth";
+        limitArg = "qpid.max_count";
+    } else if (currentMode == modeBytes) {
+        property = "byteDepth";
+        limitArg = "qpid.max_size";
+    } else
+        return;
+
+    qreal limit = 0.0;
+    const qpid::types::Variant::Map& props(data.getProperties());
+    qpid::types::Variant::Map::const_iterator args = props.find("arguments");
+    if (args != props.end() && args->second.getType() == qpid::types::VAR_MAP) {
+        const qpid::types::Variant::Map& argMap(args->second.asMap());
+        qpid::types::Variant::Map::const_iterator iter = argMap.find(limitArg);
+        if (iter != argMap.end())
+            limit = QString(iter->second.asString().c_str()).toDouble();
+    }
+
+    SummaryModel::Row row;
+    row.header = QString("time to drain");
+    row.alignment = Qt::AlignRight;
+
+    qreal depth, perSecond;
+    if (!forecast->trend(unique_property(), QString(property.c_str()), depth, perSecond))
+        row.value = QString("--");
+    else if (perSecond < 0.0) {
+        qreal seconds = BacklogForecast::eta(depth, 0.0, perSecond);
+        if (depth <= 0.0)
+            row.value = QString("empty");
+        else
+            row.value = seconds < 0.0 ? QString("steady") : BacklogForecast::formatDuration(seconds);
+    } else if (limit > 0.0) {
+        row.header = QString("time to limit");
+        qreal seconds = BacklogForecast::eta(depth, limit, perSecond);
+        row.value = seconds < 0.0 ? QString("steady") : BacklogForecast::formatDuration(seconds);
+    } else if (BacklogForecast::eta(depth, depth + 1.0, perSecond) < 0.0)
+        row.value = depth <= 0.0 ? QString("empty") : QString("steady");
+    else
+        row.value = QString("growing %1 / sec").arg((float)perSecond);
+    rows.append(row);
+}
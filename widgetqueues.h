@@ -21,6 +21,7 @@
 #define WIDGETQUEUES_H
 
 #include "widgetqmfobject.h"
+#include "backlog-forecast.h"
 
 class WidgetQueues : public WidgetQmfObject
 {
@@ -30,8 +31,15 @@ public:
     explicit WidgetQueues(QWidget *parent = 0);
     ~WidgetQueues();
 
+    // show when the current queue will drain or reach its limit
+    void setForecast(BacklogForecast *_forecast) { forecast = _forecast; }
+
 protected:
      void showRelated(const qmf::Data& object, const QString& widget_name, ArrowDirection a);
+     void derivedRows(QList<SummaryModel::Row>& rows);
+
+private:
+     BacklogForecast *forecast;
 
 };
 
@@ -0,0 +1,86 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "widgetsection.h"
+
+WidgetSection::WidgetSection(QWidget *parent, const QString& title, const QString& qmfClass, const std::string& package) :
+    WidgetQmfObject(parent),
+    sectionClass(qmfClass),
+    sectionPackage(package),
+    parentClass(),
+    refProperty()
+{
+    setObjectName(QString("widget%1").arg(title));
+    this->setSectionName(title);
+    setRelatedText(QString("Related %1").arg(title.toLower()).toStdString());
+}
+
+WidgetSection::~WidgetSection()
+{
+}
+
+void WidgetSection::addColumn(const std::string& property, const char *header, StatMode mode,
+                              bool chart, const std::string& format, Kind kind, const QString& expression)
+{
+    static const QColor chartColors[] = {QColor(Qt::red), QColor(Qt::green), QColor(Qt::blue)};
+
+    // charted columns of a mode take the colours the summary table has icons for
+    int charted = 0;
+    QList<Column>::const_iterator iter = summaryColumns.constBegin();
+    while (iter != summaryColumns.constEnd()) {
+        if ((*iter).mode == mode && (*iter).chart)
+            ++charted;
+        ++iter;
+    }
+    Column column(property, header, Qt::AlignRight, format, mode, chart, chartColors[charted % 3]);
+    column.kind = kind;
+    QString error;
+    if (!expression.isEmpty() && !column.expression.compile(expression, &error)) {
+        qWarning("%s: %s: %s", qPrintable(sectionName()), property.c_str(), qPrintable(error));
+        return;
+    }
+    summaryColumns.append(column);
+}
+
+void WidgetSection::setRelation(const QString& relatedClass, const std::string& ref)
+{
+    parentClass = relatedClass;
+    refProperty = ref;
+}
+
+// Show the objects whose ref points at the related section's current object
+void WidgetSection::showRelated(const qmf::Data& object, const QString &, ArrowDirection a)
+{
+    // a hidden section doesn't query for objects nobody will see
+    if (refProperty.empty() || isHidden())
+        return;
+
+    if (!updateAll)
+        if (this->hasData() && (arrow() != arrowNone)) {
+            emit needUpdate();
+            return;
+        }
+
+    setArrow(a);
+
+    // a reference holds the object name of the object it points at
+    related->setRelatedData(refProperty, object.getAddr().getName());
+    related->clearFilter();
+    emit needData();
+}
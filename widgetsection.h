@@ -0,0 +1,60 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef WIDGETSECTION_H
+#define WIDGETSECTION_H
+
+#include "widgetqmfobject.h"
+
+// A section for a broker class that is described by data rather than by a
+// subclass of its own: the store, links, bridges and so on.
+// Its columns are added with addColumn() or from the settings, and it can
+// follow another section, showing the objects that refer to that section's
+// current object.
+class WidgetSection : public WidgetQmfObject
+{
+    Q_OBJECT
+
+public:
+    WidgetSection(QWidget *parent, const QString& title, const QString& qmfClass, const std::string& package);
+    ~WidgetSection();
+
+    const QString& qmfClass() const { return sectionClass; }
+    const std::string& package() const { return sectionPackage; }
+
+    // a column with an expression is derived from the object's other properties
+    void addColumn(const std::string& property, const char *header, StatMode mode,
+                   bool chart = false, const std::string& format = "N",
+                   Kind kind = kindAutomatic, const QString& expression = QString());
+
+    // objects of this class point at an object of relatedClass through ref
+    void setRelation(const QString& relatedClass, const std::string& ref);
+    const QString& relatedClass() const { return parentClass; }
+
+protected:
+     void showRelated(const qmf::Data& object, const QString& widget_name, ArrowDirection a);
+
+private:
+    QString sectionClass;
+    std::string sectionPackage;
+    QString parentClass;
+    std::string refProperty;
+};
+
+#endif // WIDGETSECTION_H
@@ -19,11 +19,28 @@
 
 #include "xview.h"
 #include "ui_xview.h"
+#include "diagnostics.h"
 #include <QSettings>
+#include <QTimer>
+#include <iostream>
+#include <cstdio>
 
 XView::XView(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::XView)
+    ui(new Ui::XView),
+    openDialog(0),
+    aboutDialog(0),
+    searchDialog(0),
+    metricsExporter(0),
+    historyExport(0),
+    historyProgress(0),
+    snapshotLoaded(false),
+    headless(false),
+    alertFile(0),
+    alertClassIndex(-1),
+    metricsClassIndex(-1),
+    startupStart(Diagnostics::now()),
+    phaseStart(startupStart)
 {
     //
     // Setup some global app vales to be used by the QSettings class
@@ -34,6 +51,7 @@ XView::XView(QWidget *parent) :
 
     ui->setupUi(this);
     setupStatusBar();
+    tracePhase("main window");
 
     // allow qmf types to be passed in signals
     qRegisterMetaType<qmf::Data>();
@@ -50,6 +68,7 @@ XView::XView(QWidget *parent) :
         ui->action_Cascading->setChecked(true);
     else
         ui->action_Horizontal->setChecked(true);
+    ui->actionAnimate_transitions->setChecked(settings.value("mainWindowChecks/Animate", true).toBool());
 
     // restore the checkboxes for the update menu items
     if (settings.value("mainWindowChecks/Update", true).toBool())
@@ -87,10 +106,13 @@ XView::XView(QWidget *parent) :
     fisheyeLayout->addWidget(ui->widgetSessions);
     fisheyeLayout->addWidget(ui->widgetConnections);;
     fisheyeLayout->setCascade(ui->action_Cascading->isChecked());
+    fisheyeLayout->setAnimated(ui->actionAnimate_transitions->isChecked());
 
     connect(ui->action_Cascading, SIGNAL(toggled(bool)), fisheyeLayout, SLOT(setCascade(bool)));
+    connect(ui->actionAnimate_transitions, SIGNAL(toggled(bool)), fisheyeLayout, SLOT(setAnimated(bool)));
     connect(ui->action_Cascading, SIGNAL(toggled(bool)), ui->widgetExchanges, SLOT(showRelatedButtons(bool)));
     connect(ui->action_Horizontal, SIGNAL(changed()), this, SLOT(toggleLayout()));
+    tracePhase("layout");
 
     ui->widgetExchanges->setDrawAsRect(ui->action_Cascading->isChecked());
     ui->widgetBindings->setDrawAsRect(ui->action_Cascading->isChecked());
@@ -135,19 +157,11 @@ XView::XView(QWidget *parent) :
     // menu actions to open and close the broker connection
     connect(ui->actionOpen_localhost, SIGNAL(triggered()), qmf, SLOT(connect_localhost()));
     connect(ui->actionClose, SIGNAL(triggered()), qmf, SLOT(disconnect()));
+    connect(ui->actionExport_history, SIGNAL(triggered()), this, SLOT(exportHistory()));
 
-    //
-    // Create the dialog boxes
-    //
-    openDialog = new DialogOpen(this);
-    // when the menu item is selected, show the dialog
-    connect(ui->actionOpen_URL, SIGNAL(triggered()), openDialog, SLOT(show()));
-    // when the dialog is accepted, open the URL
-    connect(openDialog, SIGNAL(dialogOpenAccepted(QString,QString,QString)), qmf, SLOT(connect_url(QString,QString,QString)));
-
-    aboutDialog = new DialogAbout(this);
-    // when the menu item is selected, show the dialog
-    connect(ui->actionAbout, SIGNAL(triggered()), aboutDialog, SLOT(show()));
+    // The open and about dialog boxes are created when their menu item is selected
+    connect(ui->actionOpen_URL, SIGNAL(triggered()), this, SLOT(showOpenDialog()));
+    connect(ui->actionAbout, SIGNAL(triggered()), this, SLOT(showAboutDialog()));
 
     // make direct connections between the sections to simplify
     // the logistics of showing related objects
@@ -235,6 +249,15 @@ XView::XView(QWidget *parent) :
     connect(ui->actionByte_rate,    SIGNAL(triggered()), this, SLOT(setByteRateMode()));
 
 
+    // extra or replacement summary columns. The models sample whatever
+    // columns the sections end up with
+    ui->widgetExchanges->loadColumns(settings);
+    ui->widgetBindings->loadColumns(settings);
+    ui->widgetQueues->loadColumns(settings);
+    ui->widgetSubscriptions->loadColumns(settings);
+    ui->widgetSessions->loadColumns(settings);
+    ui->widgetConnections->loadColumns(settings);
+
     // The dialog boxes share the same data-model with the widgets
     // Create the dialog boxes and pass their model to the widgets
     exchangesDialog = new DialogExchanges(this, "exchanges");
@@ -314,6 +337,145 @@ XView::XView(QWidget *parent) :
     connect(connectionsDialog, SIGNAL(finalAdded()), ui->widgetConnections, SLOT(initRelated()));
     connect(ui->widgetConnections, SIGNAL(pivotTo(QModelIndex)), connectionsDialog, SLOT(setCurrentRow(QModelIndex)));
 
+    registerSection("exchange", ui->widgetExchanges, exchangesDialog);
+    registerSection("binding", ui->widgetBindings, bindingsDialog);
+    registerSection("queue", ui->widgetQueues, queuesDialog);
+    registerSection("subscription", ui->widgetSubscriptions, subscriptionsDialog);
+    registerSection("session", ui->widgetSessions, sessionsDialog);
+    registerSection("connection", ui->widgetConnections, connectionsDialog);
+    addSections(fisheyeLayout, settings);
+
+    // One search index over all the dialogs' models
+    searchIndex = new SearchIndex(this);
+    QList<ClassSection>::const_iterator iSection = classSections.constBegin();
+    while (iSection != classSections.constEnd()) {
+        searchIndex->addModel((*iSection).qmfClass, (*iSection).dialog->listModel());
+        ++iSection;
+    }
+
+    actionFind = new QAction(tr("&Find object..."), this);
+    actionFind->setShortcut(QKeySequence::Find);
+    ui->menuView->addSeparator();
+    ui->menuView->addAction(actionFind);
+    connect(actionFind, SIGNAL(triggered()), this, SLOT(showSearchDialog()));
+    tracePhase("sections and models");
+
+    // Totals over the objects related to each section's object
+    aggregator = new TopologyAggregator(this);
+    ui->widgetExchanges->addRollup(aggregator, aggregator->addRollup(tr("bound queues deep"),
+        queuesDialog->listModel(), bindingsDialog->listModel(), "exchangeRef", "queueRef", "msgDepth", false, TopologyAggregator::opSum),
+        WidgetQmfObject::modeMessages);
+    ui->widgetExchanges->addRollup(aggregator, aggregator->addRollup(tr("bound queues bytes deep"),
+        queuesDialog->listModel(), bindingsDialog->listModel(), "exchangeRef", "queueRef", "byteDepth", false, TopologyAggregator::opSum),
+        WidgetQmfObject::modeBytes);
+    ui->widgetExchanges->addRollup(aggregator, aggregator->addRollup(tr("bound queues enqueues / sec"),
+        queuesDialog->listModel(), bindingsDialog->listModel(), "exchangeRef", "queueRef", "msgTotalEnqueues", true, TopologyAggregator::opSum),
+        WidgetQmfObject::modeMessageRate);
+    ui->widgetQueues->addRollup(aggregator, aggregator->addRollup(tr("subscriptions delivered / sec"),
+        subscriptionsDialog->listModel(), "queueRef", "delivered", true, TopologyAggregator::opSum),
+        WidgetQmfObject::modeMessageRate);
+    ui->widgetSessions->addRollup(aggregator, aggregator->addRollup(tr("subscriptions delivered / sec"),
+        subscriptionsDialog->listModel(), "sessionRef", "delivered", true, TopologyAggregator::opSum),
+        WidgetQmfObject::modeMessageRate);
+    ui->widgetConnections->addRollup(aggregator, aggregator->addRollup(tr("sessions unAcked"),
+        sessionsDialog->listModel(), "connectionRef", "unackedMessages", false, TopologyAggregator::opSum),
+        WidgetQmfObject::modeMessages);
+    ui->widgetConnections->addRollup(aggregator, aggregator->addRollup(tr("most unAcked in a session"),
+        sessionsDialog->listModel(), "connectionRef", "unackedMessages", false, TopologyAggregator::opMax),
+        WidgetQmfObject::modeMessages);
+    ui->widgetConnections->addRollup(aggregator, aggregator->addRollup(tr("average unAcked / session"),
+        sessionsDialog->listModel(), "connectionRef", "unackedMessages", false, TopologyAggregator::opAverage),
+        WidgetQmfObject::modeMessages);
+
+    // Running top-N rankings, updated as each sample arrives
+    leaderboard = new Leaderboard(this);
+    leaderboard->addMetric(tr("Queue depth"), "queue", queuesDialog->listModel(), "msgDepth", false);
+    leaderboard->addMetric(tr("Queue enqueues / sec"), "queue", queuesDialog->listModel(), "msgTotalEnqueues", true);
+    leaderboard->addMetric(tr("Queue dequeues / sec"), "queue", queuesDialog->listModel(), "msgTotalDequeues", true);
+    leaderboard->addMetric(tr("Exchange drops / sec"), "exchange", exchangesDialog->listModel(), "msgDrops", true);
+    leaderboard->addMetric(tr("Session unacked"), "session", sessionsDialog->listModel(), "unackedMessages", false);
+
+    // When each queue will drain or fill, from the trend of its depth
+    backlogForecast = new BacklogForecast(queuesDialog->listModel(), QStringList() << "msgDepth" << "byteDepth");
+    ui->widgetQueues->setForecast(backlogForecast);
+
+    // Queues whose depth or rates stray from their usual pattern are highlighted
+    anomalyDetector = new AnomalyDetector(this);
+    anomalyDetector->addMetric(tr("Queue depth"), queuesDialog->listModel(), "msgDepth", false);
+    anomalyDetector->addMetric(tr("Queue enqueues / sec"), queuesDialog->listModel(), "msgTotalEnqueues", true);
+    anomalyDetector->addMetric(tr("Queue dequeues / sec"), queuesDialog->listModel(), "msgTotalDequeues", true);
+
+    leaderboardDock = new DockLeaderboard(this, leaderboard);
+    addDockWidget(Qt::RightDockWidgetArea, leaderboardDock);
+    leaderboardDock->hide();
+    ui->menuView->addAction(leaderboardDock->toggleViewAction());
+    connect(leaderboardDock, SIGNAL(setCurrentObject(qmf::Data,QString)),
+            this, SLOT(searchSelected(qmf::Data,QString)));
+
+    // restore the checkboxes for the rate smoothing menu items
+    rateGroup = new QActionGroup(ui->menu_Edit);
+    rateGroup->addAction(ui->actionRate_instant);
+    rateGroup->addAction(ui->actionRate_1_minute);
+    rateGroup->addAction(ui->actionRate_5_minutes);
+    rateGroup->setExclusive(true);
+    int rateWindow = settings.value("mainWindowChecks/RateWindow", SampleRate::windowInstant).toInt();
+    if (rateWindow == SampleRate::windowOneMinute)
+        ui->actionRate_1_minute->setChecked(true);
+    else if (rateWindow == SampleRate::windowFiveMinutes)
+        ui->actionRate_5_minutes->setChecked(true);
+    else
+        ui->actionRate_instant->setChecked(true);
+    toggleRateWindow();
+    connect(rateGroup, SIGNAL(triggered(QAction*)), this, SLOT(toggleRateWindow()));
+
+    // samples can also be kept on disk so history survives a restart.
+    // The stores scan their segments, so they are opened in startupFinished()
+    // or, for a broker connected later, in brokerConnected()
+    ui->actionKeep_history_on_disk->setChecked(settings.value("mainWindowChecks/History", false).toBool());
+    connect(ui->actionKeep_history_on_disk, SIGNAL(toggled(bool)), this, SLOT(toggleHistoryStore(bool)));
+
+    // Alert rules are evaluated as each sample arrives
+    alertEngine = new AlertEngine(this);
+    iSection = classSections.constBegin();
+    while (iSection != classSections.constEnd()) {
+        alertEngine->addModel((*iSection).qmfClass, (*iSection).dialog->listModel());
+        ++iSection;
+    }
+    QStringList rules = settings.value("alerts/rules").toStringList();
+    for (int i=0; i<rules.size(); ++i)
+        alertEngine->addRule(rules.at(i));
+    connect(alertEngine, SIGNAL(alertRaised(QString,QString,QString,qreal)),
+            this, SLOT(alertRaised(QString,QString,QString,qreal)));
+    connect(alertEngine, SIGNAL(alertCleared(QString,QString,QString,qreal)),
+            this, SLOT(alertCleared(QString,QString,QString,qreal)));
+    connect(qmf, SIGNAL(qmfTimer()), this, SLOT(queryAlerts()));
+
+    alertsDock = new DockAlerts(this, alertEngine);
+    addDockWidget(Qt::RightDockWidgetArea, alertsDock);
+    alertsDock->hide();
+    ui->menuView->addAction(alertsDock->toggleViewAction());
+    connect(alertsDock, SIGNAL(setCurrentObject(qmf::Data,QString)),
+            this, SLOT(searchSelected(qmf::Data,QString)));
+    connect(alertsDock, SIGNAL(rulesChanged()), this, SLOT(saveRules()));
+    connect(alertsDock, SIGNAL(ruleError(QString)), this, SLOT(showMessage(QString)));
+
+    // Query round trips and gui timings
+    diagnosticsDock = new DockDiagnostics(this);
+    addDockWidget(Qt::RightDockWidgetArea, diagnosticsDock);
+    diagnosticsDock->hide();
+    ui->menuView->addAction(diagnosticsDock->toggleViewAction());
+    connect(diagnosticsDock, SIGNAL(summaryChanged(QString)), label_diagnostics, SLOT(setText(QString)));
+
+    // Move all the sections back through the recorded history
+    timelineBar = new TimelineBar(this);
+    addToolBar(Qt::BottomToolBarArea, timelineBar);
+    ui->menuView->addAction(timelineBar->toggleViewAction());
+    connect(timelineBar, SIGNAL(viewTimeChanged(qint64)), this, SLOT(setViewTime(qint64)));
+
+    tracePhase("docks");
+    restoreState(settings.value("mainWindowState").toByteArray());
+    tracePhase("restore state");
+
     //
     // Create linkages to enable and disable main-window components based on the connection status.
     //
@@ -321,53 +483,121 @@ XView::XView(QWidget *parent) :
     connect(qmf, SIGNAL(isConnected(bool)), ui->actionOpen_URL,          SLOT(setDisabled(bool)));
     connect(qmf, SIGNAL(isConnected(bool)), ui->actionClose,             SLOT(setEnabled(bool)));
 
-    connect(qmf, SIGNAL(isConnected(bool)), ui->widgetExchanges,         SLOT(setEnabled(bool)));
-    connect(qmf, SIGNAL(isConnected(bool)), ui->widgetBindings,          SLOT(setEnabled(bool)));
-    connect(qmf, SIGNAL(isConnected(bool)), ui->widgetQueues,            SLOT(setEnabled(bool)));
-    connect(qmf, SIGNAL(isConnected(bool)), ui->widgetSubscriptions,     SLOT(setEnabled(bool)));
-    connect(qmf, SIGNAL(isConnected(bool)), ui->widgetSessions,          SLOT(setEnabled(bool)));
-    connect(qmf, SIGNAL(isConnected(bool)), ui->widgetConnections,       SLOT(setEnabled(bool)));
-
-    connect(qmf, SIGNAL(isConnected(bool)), exchangesDialog,             SLOT(connectionChanged(bool)));
-    connect(qmf, SIGNAL(isConnected(bool)), bindingsDialog,              SLOT(connectionChanged(bool)));
-    connect(qmf, SIGNAL(isConnected(bool)), queuesDialog,                SLOT(connectionChanged(bool)));
-    connect(qmf, SIGNAL(isConnected(bool)), subscriptionsDialog,         SLOT(connectionChanged(bool)));
-    connect(qmf, SIGNAL(isConnected(bool)), sessionsDialog,              SLOT(connectionChanged(bool)));
-    connect(qmf, SIGNAL(isConnected(bool)), connectionsDialog,           SLOT(connectionChanged(bool)));
+    // show the last known objects of a broker as soon as we connect to it
+    iSection = classSections.constBegin();
+    while (iSection != classSections.constEnd()) {
+        connect(qmf, SIGNAL(isConnected(bool)), (*iSection).widget, SLOT(setEnabled(bool)));
+        connect(qmf, SIGNAL(isConnected(bool)), (*iSection).dialog, SLOT(connectionChanged(bool)));
+        snapshot.addModel((*iSection).qmfClass, (*iSection).dialog->listModel());
+        ++iSection;
+    }
+    connect(qmf, SIGNAL(connectedTo(QString)), this, SLOT(brokerConnected(QString)));
+    connect(qmf, SIGNAL(isConnected(bool)), this, SLOT(reconcileSnapshot(bool)));
+    connect(ui->actionClose, SIGNAL(triggered()), this, SLOT(saveSnapshot()));
 
     // always start on the message mode
     setMessageMode();
+    tracePhase("connections");
 
+    // runs once the window is up and the event loop has started
+    QTimer::singleShot(0, this, SLOT(startupFinished()));
+}
+
+// Record how long a part of the constructor took
+void XView::tracePhase(const char *phase)
+{
+    qint64 now = Diagnostics::now();
+    Diagnostics::record(QString("startup: %1").arg(phase), now - phaseStart);
+    phaseStart = now;
+}
+
+// SLOT triggered on the first pass through the event loop
+// Record the time to the first paint and do the work that was put off
+void XView::startupFinished()
+{
+    static const qint64 budgetMs = 500;
+
+    qint64 elapsed = Diagnostics::now() - startupStart;
+    Diagnostics::record("startup: first event loop", elapsed);
+    if (elapsed / 1000000 > budgetMs)
+        qWarning("Startup took %lld ms, over the %lld ms budget", elapsed / 1000000, budgetMs);
+
+    if (ui->actionKeep_history_on_disk->isChecked())
+        toggleHistoryStore(true);
+}
+
+// SLOT triggered by File->Open URL
+void XView::showOpenDialog()
+{
+    if (!openDialog) {
+        openDialog = new DialogOpen(this);
+        // when the dialog is accepted, open the URL
+        connect(openDialog, SIGNAL(dialogOpenAccepted(QString,QString,QString)), qmf, SLOT(connect_url(QString,QString,QString)));
+    }
+    openDialog->show();
+}
+
+// SLOT triggered by Help->About
+void XView::showAboutDialog()
+{
+    if (!aboutDialog)
+        aboutDialog = new DialogAbout(this);
+    aboutDialog->show();
+}
+
+// SLOT triggered by View->Find object
+void XView::showSearchDialog()
+{
+    if (!searchDialog) {
+        searchDialog = new DialogSearch(this, searchIndex);
+        connect(searchDialog, SIGNAL(setCurrentObject(qmf::Data,QString)),
+                this, SLOT(searchSelected(qmf::Data,QString)));
+    }
+    searchDialog->popup();
 }
 
 void XView::toggleChartType()
 {
-    ui->widgetExchanges->setChartType(ui->actionDraw_area_charts->isChecked());
-    ui->widgetBindings->setChartType(ui->actionDraw_area_charts->isChecked());
-    ui->widgetQueues->setChartType(ui->actionDraw_area_charts->isChecked());
-    ui->widgetSubscriptions->setChartType(ui->actionDraw_area_charts->isChecked());
-    ui->widgetSessions->setChartType(ui->actionDraw_area_charts->isChecked());
-    ui->widgetConnections->setChartType(ui->actionDraw_area_charts->isChecked());
+    QList<ClassSection>::const_iterator iter = classSections.constBegin();
+    while (iter != classSections.constEnd()) {
+        (*iter).widget->setChartType(ui->actionDraw_area_charts->isChecked());
+        ++iter;
+    }
+}
+
+// Tell the models which rate to show in the tables, charts and leaderboard
+// The displays pick up the new rates the next time they refresh
+void XView::toggleRateWindow()
+{
+    SampleRate::Window window = SampleRate::windowInstant;
+    if (ui->actionRate_1_minute->isChecked())
+        window = SampleRate::windowOneMinute;
+    else if (ui->actionRate_5_minutes->isChecked())
+        window = SampleRate::windowFiveMinutes;
+
+    QList<ClassSection>::const_iterator iter = classSections.constBegin();
+    while (iter != classSections.constEnd()) {
+        (*iter).dialog->listModel()->setRateWindow(window);
+        ++iter;
+    }
 }
 
 void XView::toggleUpdate()
 {
-    ui->widgetExchanges->setUpdateStrategy(ui->actionUpdate_all->isChecked());
-    ui->widgetBindings->setUpdateStrategy(ui->actionUpdate_all->isChecked());
-    ui->widgetQueues->setUpdateStrategy(ui->actionUpdate_all->isChecked());
-    ui->widgetSubscriptions->setUpdateStrategy(ui->actionUpdate_all->isChecked());
-    ui->widgetSessions->setUpdateStrategy(ui->actionUpdate_all->isChecked());
-    ui->widgetConnections->setUpdateStrategy(ui->actionUpdate_all->isChecked());
+    QList<ClassSection>::const_iterator iter = classSections.constBegin();
+    while (iter != classSections.constEnd()) {
+        (*iter).widget->setUpdateStrategy(ui->actionUpdate_all->isChecked());
+        ++iter;
+    }
 }
 
 void XView::toggleLayout()
 {
-    ui->widgetExchanges->setDrawAsRect(ui->action_Cascading->isChecked());
-    ui->widgetBindings->setDrawAsRect(ui->action_Cascading->isChecked());
-    ui->widgetQueues->setDrawAsRect(ui->action_Cascading->isChecked());
-    ui->widgetSubscriptions->setDrawAsRect(ui->action_Cascading->isChecked());
-    ui->widgetSessions->setDrawAsRect(ui->action_Cascading->isChecked());
-    ui->widgetConnections->setDrawAsRect(ui->action_Cascading->isChecked());
+    QList<ClassSection>::const_iterator iter = classSections.constBegin();
+    while (iter != classSections.constEnd()) {
+        (*iter).widget->setDrawAsRect(ui->action_Cascading->isChecked());
+        ++iter;
+    }
 
     ui->centralWidget->layout()->update();
 }
@@ -379,6 +609,10 @@ void XView::setupStatusBar() {
     label_connection_prompt->setText("Connection status: ");
     statusBar()->addWidget(label_connection_prompt);
     statusBar()->addWidget(label_connection_status);
+    label_alerts = new QLabel();
+    statusBar()->addPermanentWidget(label_alerts);
+    label_diagnostics = new QLabel();
+    statusBar()->addPermanentWidget(label_diagnostics);
 
     ui->actionMessages->setIcon(QIcon(":/images/messages.png"));
     ui->actionBytes->setIcon(QIcon(":/images/bytes.png"));
@@ -428,24 +662,28 @@ void XView::setupStatusBar() {
 // If there is a current object in a widget, refresh it
 void XView::queryCurrent()
 {
-    if (ui->widgetExchanges->current())
-        qmf->queryObject(ui->widgetExchanges->getDataAddr(), exchangesDialog);
-    else if (ui->widgetBindings->current())
-        qmf->queryObject(ui->widgetBindings->getDataAddr(), bindingsDialog);
-    else if (ui->widgetQueues->current())
-        qmf->queryObject(ui->widgetQueues->getDataAddr(), queuesDialog);
-    else if (ui->widgetSubscriptions->current())
-        qmf->queryObject(ui->widgetSubscriptions->getDataAddr(), subscriptionsDialog);
-    else if (ui->widgetSessions->current())
-        qmf->queryObject(ui->widgetSessions->getDataAddr(), sessionsDialog);
-    else if (ui->widgetConnections->current())
-        qmf->queryObject(ui->widgetConnections->getDataAddr(), connectionsDialog);
+    QList<ClassSection>::const_iterator iter = classSections.constBegin();
+    while (iter != classSections.constEnd()) {
+        if ((*iter).widget->current()) {
+            qmf->queryObject((*iter).widget->getDataAddr(), (*iter).dialog);
+            return;
+        }
+        ++iter;
+    }
 }
 
 // Send an async query to get the list of objects
 // When the response is received, send an event to the object's dialog
 void XView::queryObjects(const std::string& qmf_class, DialogObjects* dialog)
 {
+    QList<Section>::const_iterator iter = sections.constBegin();
+    while (iter != sections.constEnd()) {
+        if ((*iter).dialog == dialog) {
+            qmf->queryBroker(qmf_class, dialog, (*iter).widget->package());
+            return;
+        }
+        ++iter;
+    }
     qmf->queryBroker(qmf_class, dialog);
 }
 
@@ -541,6 +779,233 @@ void XView::updateConnection()
         qmf->queryObject(ui->widgetConnections->getDataAddr(), connectionsDialog);
 }
 
+// SLOT: triggered when an extra section, or its button, wants all of its objects
+void XView::querySection()
+{
+    QList<Section>::const_iterator iter = sections.constBegin();
+    while (iter != sections.constEnd()) {
+        if (sender() == (*iter).widget || sender() == (*iter).widget->pushButton()) {
+            queryObjects((*iter).widget->qmfClass().toStdString(), (*iter).dialog);
+            return;
+        }
+        ++iter;
+    }
+}
+
+// SLOT: triggered when an extra section wants its object refreshed
+void XView::updateSection()
+{
+    QList<Section>::const_iterator iter = sections.constBegin();
+    while (iter != sections.constEnd()) {
+        if (sender() == (*iter).widget) {
+            if ((*iter).dialog->isHidden())
+                qmf->queryObject((*iter).widget->getDataAddr(), (*iter).dialog);
+            return;
+        }
+        ++iter;
+    }
+}
+
+namespace {
+
+// The broker classes beyond the six built in sections. Each is shown as a
+// section of its own once it is turned on in the View menu
+struct SectionSpec {
+    const char *title;
+    const char *qmfClass;
+    const char *package;
+    const char *key;            // unique property
+    const char *relatedClass;   // the class the ref points at
+    const char *ref;
+    const char *keyExpression;  // derives the key when no property is unique
+};
+
+const char * const brokerPackage = "org.apache.qpid.broker";
+const char * const storePackage = "com.redhat.rhm.store";
+
+const SectionSpec sectionSpecs[] = {
+    {"Broker",   "broker",  brokerPackage, "name",     "",           "",              ""},
+    {"Vhosts",   "vhost",   brokerPackage, "name",     "broker",     "brokerRef",     ""},
+    {"Links",    "link",    brokerPackage, "name",     "vhost",      "vhostRef",      ""},
+    {"Bridges",  "bridge",  brokerPackage, "name",     "link",       "linkRef",       ""},
+    // many agents share a label. The broker and agent banks together are unique
+    {"Agents",   "agent",   brokerPackage, "agentId",  "connection", "connectionRef", "brokerBank * 4294967296 + agentBank"},
+    {"Store",    "store",   storePackage,  "location", "broker",     "brokerRef",     ""},
+    {"Journals", "journal", storePackage,  "name",     "queue",      "queueRef",      ""}
+};
+
+struct ColumnSpec {
+    const char *qmfClass;
+    const char *property;
+    const char *header;
+    WidgetQmfObject::StatMode mode;
+    bool chart;
+    const char *format;
+    WidgetQmfObject::Kind kind;
+};
+
+const ColumnSpec columnSpecs[] = {
+    {"broker",  "msgDepth",             "deep",                     WidgetQmfObject::modeMessages,    true,  "N", WidgetQmfObject::kindAutomatic},
+    {"broker",  "msgTotalEnqueues",     "total enqueues",           WidgetQmfObject::modeMessages,    true,  "N", WidgetQmfObject::kindAutomatic},
+    {"broker",  "msgTotalDequeues",     "total dequeues",           WidgetQmfObject::modeMessages,    true,  "N", WidgetQmfObject::kindAutomatic},
+    {"broker",  "discardsNoRoute",      "discarded, no route",      WidgetQmfObject::modeMessages,    false, "N", WidgetQmfObject::kindAutomatic},
+    {"broker",  "byteDepth",            "deep",                     WidgetQmfObject::modeBytes,       true,  "B", WidgetQmfObject::kindAutomatic},
+    {"broker",  "byteTotalEnqueues",    "total enqueues",           WidgetQmfObject::modeBytes,       true,  "B", WidgetQmfObject::kindAutomatic},
+    {"broker",  "byteTotalDequeues",    "total dequeues",           WidgetQmfObject::modeBytes,       true,  "B", WidgetQmfObject::kindAutomatic},
+    {"broker",  "msgTotalEnqueues",     "total enqueues / sec",     WidgetQmfObject::modeMessageRate, true,  "N", WidgetQmfObject::kindAutomatic},
+    {"broker",  "msgTotalDequeues",     "total dequeues / sec",     WidgetQmfObject::modeMessageRate, true,  "N", WidgetQmfObject::kindAutomatic},
+    {"broker",  "discardsNoRoute",      "discarded, no route / sec", WidgetQmfObject::modeMessageRate, false, "N", WidgetQmfObject::kindAutomatic},
+    {"broker",  "byteTotalEnqueues",    "total enqueues / sec",     WidgetQmfObject::modeByteRate,    true,  "N", WidgetQmfObject::kindAutomatic},
+    {"broker",  "byteTotalDequeues",    "total dequeues / sec",     WidgetQmfObject::modeByteRate,    true,  "N", WidgetQmfObject::kindAutomatic},
+    {"link",    "host",                 "host",                     WidgetQmfObject::modeMessages,    false, "N", WidgetQmfObject::kindText},
+    {"link",    "port",                 "port",                     WidgetQmfObject::modeMessages,    false, "N", WidgetQmfObject::kindGauge},
+    {"link",    "state",                "state",                    WidgetQmfObject::modeMessages,    false, "N", WidgetQmfObject::kindText},
+    {"link",    "lastError",            "last error",               WidgetQmfObject::modeMessages,    false, "N", WidgetQmfObject::kindText},
+    {"bridge",  "src",                  "source",                   WidgetQmfObject::modeMessages,    false, "N", WidgetQmfObject::kindText},
+    {"bridge",  "dest",                 "destination",              WidgetQmfObject::modeMessages,    false, "N", WidgetQmfObject::kindText},
+    {"bridge",  "key",                  "key",                      WidgetQmfObject::modeMessages,    false, "N", WidgetQmfObject::kindText},
+    {"agent",   "label",                "label",                    WidgetQmfObject::modeMessages,    false, "N", WidgetQmfObject::kindText},
+    {"agent",   "systemId",             "system",                   WidgetQmfObject::modeMessages,    false, "N", WidgetQmfObject::kindText},
+    {"agent",   "agentBank",            "agent bank",               WidgetQmfObject::modeMessages,    false, "N", WidgetQmfObject::kindGauge},
+    {"store",   "tplTransactionDepth",  "transactions open",        WidgetQmfObject::modeMessages,    true,  "N", WidgetQmfObject::kindGauge},
+    {"store",   "tplTxnCommits",        "commits",                  WidgetQmfObject::modeMessages,    true,  "N", WidgetQmfObject::kindAutomatic},
+    {"store",   "tplTxnAborts",         "aborts",                   WidgetQmfObject::modeMessages,    true,  "N", WidgetQmfObject::kindAutomatic},
+    {"store",   "tplOutstandingAIOs",   "outstanding writes",       WidgetQmfObject::modeMessages,    false, "N", WidgetQmfObject::kindGauge},
+    {"store",   "tplTxnCommits",        "commits / sec",            WidgetQmfObject::modeMessageRate, true,  "N", WidgetQmfObject::kindAutomatic},
+    {"store",   "tplTxnAborts",         "aborts / sec",             WidgetQmfObject::modeMessageRate, true,  "N", WidgetQmfObject::kindAutomatic},
+    {"journal", "recordDepth",          "records",                  WidgetQmfObject::modeMessages,    true,  "N", WidgetQmfObject::kindGauge},
+    {"journal", "enqueues",             "enqueues",                 WidgetQmfObject::modeMessages,    true,  "N", WidgetQmfObject::kindAutomatic},
+    {"journal", "dequeues",             "dequeues",                 WidgetQmfObject::modeMessages,    true,  "N", WidgetQmfObject::kindAutomatic},
+    {"journal", "outstandingAIOs",      "outstanding writes",       WidgetQmfObject::modeMessages,    false, "N", WidgetQmfObject::kindGauge},
+    {"journal", "availableFileCount",   "files available",          WidgetQmfObject::modeMessages,    false, "N", WidgetQmfObject::kindGauge},
+    {"journal", "writeWaitFailures",    "write waits",              WidgetQmfObject::modeMessages,    false, "N", WidgetQmfObject::kindAutomatic},
+    {"journal", "enqueues",             "enqueues / sec",           WidgetQmfObject::modeMessageRate, true,  "N", WidgetQmfObject::kindAutomatic},
+    {"journal", "dequeues",             "dequeues / sec",           WidgetQmfObject::modeMessageRate, true,  "N", WidgetQmfObject::kindAutomatic},
+    {"journal", "writeWaitFailures",    "write waits / sec",        WidgetQmfObject::modeMessageRate, false, "N", WidgetQmfObject::kindAutomatic}
+};
+
+}
+
+// Create the sections for the classes in sectionSpecs, and for any in the
+// settings' "sections" array, which has the same fields:
+//   [sections]
+//   section\size=1
+//   section\1\title=Clusters
+//   section\1\class=cluster
+//   section\1\package=org.apache.qpid.cluster
+//   section\1\key=clusterName
+// Their columns can be added to from [columns/<title>] like any section's.
+void XView::addSections(FisheyeLayout *layout, QSettings& settings)
+{
+    for (unsigned i=0; i<sizeof(sectionSpecs) / sizeof(sectionSpecs[0]); ++i) {
+        const SectionSpec& spec = sectionSpecs[i];
+        WidgetSection *widget = new WidgetSection(ui->centralWidget, spec.title, spec.qmfClass, spec.package);
+        if (*spec.keyExpression)
+            widget->addColumn(spec.key, "id", WidgetQmfObject::modeMessages, false, "N",
+                              WidgetQmfObject::kindGauge, spec.keyExpression);
+        for (unsigned c=0; c<sizeof(columnSpecs) / sizeof(columnSpecs[0]); ++c) {
+            const ColumnSpec& column = columnSpecs[c];
+            if (widget->qmfClass() == column.qmfClass)
+                widget->addColumn(column.property, column.header, column.mode, column.chart, column.format, column.kind);
+        }
+        if (*spec.ref)
+            widget->setRelation(spec.relatedClass, spec.ref);
+        addSection(layout, widget, spec.key, settings);
+    }
+
+    // addSection() reads the settings too, so the configured sections are
+    // added once the array has been read
+    int size = settings.beginReadArray("sections/section");
+    QList<WidgetSection *> configured;
+    QStringList keys;
+    QStringList classes;
+    for (int i=0; i<size; ++i) {
+        settings.setArrayIndex(i);
+        QString title = settings.value("title").toString();
+        QString qmfClass = settings.value("class").toString();
+        if (title.isEmpty() || qmfClass.isEmpty() || widgetFor(qmfClass) || classes.contains(qmfClass))
+            continue;
+        classes.append(qmfClass);
+        WidgetSection *widget = new WidgetSection(ui->centralWidget, title, qmfClass,
+                settings.value("package", brokerPackage).toString().toStdString());
+        QString ref = settings.value("ref").toString();
+        if (!ref.isEmpty())
+            widget->setRelation(settings.value("relatedClass").toString(), ref.toStdString());
+        configured.append(widget);
+        keys.append(settings.value("key", "name").toString());
+    }
+    settings.endArray();
+    for (int i=0; i<configured.size(); ++i)
+        addSection(layout, configured.at(i), keys.at(i).toStdString(), settings);
+
+    // every section resets the others when it becomes current, and an extra
+    // section follows the current object of the section its objects refer to
+    QList<WidgetQmfObject *> builtIn;
+    builtIn << ui->widgetExchanges << ui->widgetBindings << ui->widgetQueues
+            << ui->widgetSubscriptions << ui->widgetSessions << ui->widgetConnections;
+    QList<Section>::const_iterator iter = sections.constBegin();
+    while (iter != sections.constEnd()) {
+        WidgetSection *widget = (*iter).widget;
+        ++iter;
+
+        widget->peers = builtIn;
+        for (int i=0; i<builtIn.size(); ++i)
+            builtIn.at(i)->peers.append(widget);
+        QList<Section>::const_iterator other = sections.constBegin();
+        while (other != sections.constEnd()) {
+            if ((*other).widget != widget)
+                widget->peers.append((*other).widget);
+            ++other;
+        }
+
+        WidgetQmfObject *followed = widget->relatedClass().isEmpty() ? 0 : widgetFor(widget->relatedClass());
+        if (followed)
+            followed->followers.append(widget);
+    }
+}
+
+void XView::addSection(FisheyeLayout *layout, WidgetSection *widget, const std::string& key, QSettings& settings)
+{
+    widget->loadColumns(settings);
+    widget->setEnabled(false);
+    widget->setDrawAsRect(ui->action_Cascading->isChecked());
+    widget->showChart(ui->actionCharts->isChecked());
+    widget->setChartType(ui->actionDraw_area_charts->isChecked());
+    widget->setUpdateStrategy(ui->actionUpdate_all->isChecked());
+    widget->initRelatedButtons();
+    connect(ui->actionCharts, SIGNAL(toggled(bool)), widget, SLOT(showChart(bool)));
+    layout->addWidget(widget);
+
+    DialogObjects *dialog = new DialogObjects(this, widget->sectionName().toLower().toStdString());
+    dialog->initModels(key, widget->getSampleProperties());
+    widget->setRelatedModel(dialog->listModel(), this);
+    connect(dialog, SIGNAL(setCurrentObject(qmf::Data,QString)), widget, SLOT(setCurrentObject(qmf::Data)));
+    connect(dialog, SIGNAL(objectRefreshed()), widget, SLOT(objectRefreshed()));
+    connect(dialog, SIGNAL(finalAdded()), widget, SLOT(initRelated()));
+    connect(widget, SIGNAL(pivotTo(QModelIndex)), dialog, SLOT(setCurrentRow(QModelIndex)));
+    connect(widget->pushButton(), SIGNAL(clicked()), this, SLOT(querySection()));
+    connect(widget->pushButton(), SIGNAL(clicked()), dialog, SLOT(exec()));
+    connect(widget, SIGNAL(needData()), this, SLOT(querySection()));
+    connect(widget, SIGNAL(needUpdate()), this, SLOT(updateSection()));
+
+    // the extra sections are hidden until they are turned on
+    QAction *action = new QAction(tr("Show %1").arg(widget->sectionName().toLower()), this);
+    action->setCheckable(true);
+    action->setChecked(settings.value(QString("sections/%1/visible").arg(widget->sectionName()), false).toBool());
+    widget->setVisible(action->isChecked());
+    connect(action, SIGNAL(toggled(bool)), widget, SLOT(setVisible(bool)));
+    if (sections.isEmpty())
+        ui->menuView->addSeparator();
+    ui->menuView->addAction(action);
+
+    Section section;
+    section.widget = widget;
+    section.dialog = dialog;
+    section.action = action;
+    sections.append(section);
+    registerSection(widget->qmfClass(), widget, dialog);
+}
+
 void XView::setMessageMode()
 {
     setMode(WidgetQmfObject::modeMessages);
@@ -559,44 +1024,409 @@ void XView::setByteRateMode()
 }
 void XView::setMode(WidgetQmfObject::StatMode mode)
 {
-    ui->widgetBindings->setCurrentMode(mode);
-    ui->widgetExchanges->setCurrentMode(mode);
-    ui->widgetQueues->setCurrentMode(mode);
-    ui->widgetSubscriptions->setCurrentMode(mode);
-    ui->widgetSessions->setCurrentMode(mode);
-    ui->widgetConnections->setCurrentMode(mode);
+    QList<ClassSection>::const_iterator iter = classSections.constBegin();
+    while (iter != classSections.constEnd()) {
+        (*iter).widget->setCurrentMode(mode);
+        ++iter;
+    }
+}
+
+// Add a section to the list that the per class subsystems are driven from
+void XView::registerSection(const QString& qmfClass, WidgetQmfObject *widget, DialogObjects *dialog)
+{
+    ClassSection section;
+    section.qmfClass = qmfClass;
+    section.widget = widget;
+    section.dialog = dialog;
+    classSections.append(section);
+}
+
+// Return the section that shows objects of this qmf class
+WidgetQmfObject *XView::widgetFor(const QString& qmfClass)
+{
+    QList<ClassSection>::const_iterator iter = classSections.constBegin();
+    while (iter != classSections.constEnd()) {
+        if ((*iter).qmfClass == qmfClass)
+            return (*iter).widget;
+        ++iter;
+    }
+    return 0;
+}
+
+// Return the dialog that holds the objects of this qmf class
+DialogObjects *XView::dialogFor(const QString& qmfClass)
+{
+    QList<ClassSection>::const_iterator iter = classSections.constBegin();
+    while (iter != classSections.constEnd()) {
+        if ((*iter).qmfClass == qmfClass)
+            return (*iter).dialog;
+        ++iter;
+    }
+    return 0;
+}
+
+// SLOT triggered when an object is picked in the search palette, the leaderboard or the alerts
+void XView::searchSelected(const qmf::Data& object, const QString& qmfClass)
+{
+    WidgetQmfObject *widget = widgetFor(qmfClass);
+    if (widget)
+        widget->setCurrentObject(object);
+}
+
+// SLOT Triggered when the qmf thread has been idle for 3 seconds
+// The alert rules only see the objects that are queried, so query all the objects
+// of one class that has rules. Each tick moves on to the next class.
+void XView::queryAlerts()
+{
+    QStringList classes = alertEngine->classes();
+    if (classes.isEmpty())
+        return;
+
+    alertClassIndex = (alertClassIndex + 1) % classes.size();
+    QString qmfClass = classes.at(alertClassIndex);
+    DialogObjects *dialog = dialogFor(qmfClass);
+    if (dialog)
+        queryObjects(qmfClass.toStdString(), dialog);
+}
+
+// SLOT triggered when the qmf thread is idle and metrics are being exported.
+// Refresh one exported class per tick so every series stays current
+void XView::queryMetrics()
+{
+    QStringList classes = metricsExporter->classes();
+    metricsClassIndex = (metricsClassIndex + 1) % classes.size();
+    QString qmfClass = classes.at(metricsClassIndex);
+    queryObjects(qmfClass.toStdString(), dialogFor(qmfClass));
+}
+
+// SLOT triggered when the qmf session to a broker is open
+void XView::brokerConnected(const QString& url)
+{
+    brokerUrl = url;
+    if (ui->actionKeep_history_on_disk->isChecked())
+        toggleHistoryStore(true);
+    int count = snapshot.load(url);
+    if (count > 0) {
+        snapshotLoaded = true;
+        statusBar()->showMessage(tr("Showing %1 objects from the last session until the broker answers").arg(count), 5000);
+    }
+}
+
+// SLOT triggered when the broker agent is ready, or the connection closed.
+// Query every class once so the snapshot's objects are replaced by live ones
+void XView::reconcileSnapshot(bool connected)
+{
+    if (!connected) {
+        brokerUrl.clear();
+        snapshotLoaded = false;
+        return;
+    }
+    if (!snapshotLoaded)
+        return;
+    snapshotLoaded = false;
+    QList<ClassSection>::const_iterator iter = classSections.constBegin();
+    while (iter != classSections.constEnd()) {
+        queryObjects((*iter).qmfClass.toStdString(), (*iter).dialog);
+        ++iter;
+    }
+}
+
+// SLOT triggered before disconnecting, and on exit
+void XView::saveSnapshot()
+{
+    if (!brokerUrl.isEmpty())
+        snapshot.save(brokerUrl);
+}
+
+// SLOT triggered when Keep history on disk is toggled, and when a broker is connected.
+// Each broker has its own directory under the application's data directory,
+// and each class its own store in there, so the objects of one broker are
+// never shown with the history of another broker's objects of the same name
+void XView::toggleHistoryStore(bool keep)
+{
+    // an export may be reading the stores that are about to be closed
+    if (historyExport) {
+        historyExport->cancel();
+        historyExport->wait();
+    }
+    QList<ClassSection>::const_iterator iter = classSections.constBegin();
+    while (iter != classSections.constEnd()) {
+        (*iter).dialog->listModel()->setStore(0);
+        ++iter;
+    }
+    qDeleteAll(historyStores);
+    historyStores.clear();
+    // without the store, the timeline only reaches back as far as the samples in memory
+    timelineBar->setSpan(keep ? 24 * 3600 : 600);
+    // the stores are opened once we know which broker they are for
+    if (!keep || brokerUrl.isEmpty())
+        return;
+
+    QString base = QDesktopServices::storageLocation(QDesktopServices::DataLocation) + "/history/"
+            + TopologySnapshot::brokerKey(brokerUrl) + "/";
+    iter = classSections.constBegin();
+    while (iter != classSections.constEnd()) {
+        ObjectListModel *model = (*iter).dialog->listModel();
+        SegmentStore *store = new SegmentStore(this, base + (*iter).qmfClass, model->sampled());
+        store->attach(model);
+        model->setStore(store);
+        historyStores.append(store);
+        ++iter;
+    }
+}
+
+// SLOT triggered when the timeline settles on a new time
+// Every section shows its values as of that time. Refreshing the current
+// section carries the time over to the sections showing related objects
+void XView::setViewTime(qint64 msecs)
+{
+    QList<ClassSection>::const_iterator iter = classSections.constBegin();
+    while (iter != classSections.constEnd()) {
+        (*iter).widget->setViewTime(msecs);
+        ++iter;
+    }
+    iter = classSections.constBegin();
+    while (iter != classSections.constEnd()) {
+        (*iter).widget->objectRefreshed();
+        ++iter;
+    }
+}
+
+// SLOT triggered by File->Export history
+// Write the samples of the current object, or of a whole class, to a file
+void XView::exportHistory()
+{
+    if (historyExport)
+        return;
+
+    QStringList choices;
+    QList<QPair<QString, QString> > scopes;   // class, object name (empty for all)
+    QList<ClassSection>::const_iterator iter = classSections.constBegin();
+    while (iter != classSections.constEnd()) {
+        const QString &qmfClass = (*iter).qmfClass;
+        WidgetQmfObject *widget = (*iter).widget;
+        if (widget->current() && widget->hasData()) {
+            ObjectListModel *model = (*iter).dialog->listModel();
+            QString name(widget->currentData().getProperty(model->unique(false)).asString().c_str());
+            choices.prepend(tr("Current %1 %2").arg(qmfClass).arg(name));
+            scopes.prepend(qMakePair(qmfClass, name));
+        }
+        choices.append(tr("All %1 objects").arg(qmfClass));
+        scopes.append(qMakePair(qmfClass, QString()));
+        ++iter;
+    }
+
+    bool ok;
+    QString choice = QInputDialog::getItem(this, tr("Export history"), tr("Export the samples of"), choices, 0, false, &ok);
+    if (!ok)
+        return;
+    QPair<QString, QString> scope = scopes.at(choices.indexOf(choice));
+
+    QString filter;
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export history"), scope.first + "-history.csv",
+                                                    tr("CSV files (*.csv);;Columnar files (*.xvh)"), &filter);
+    if (fileName.isEmpty())
+        return;
+    HistoryExport::Format format = (fileName.endsWith(".xvh") || filter.contains("xvh"))
+            ? HistoryExport::formatColumnar : HistoryExport::formatCsv;
+
+    ObjectListModel *model = dialogFor(scope.first)->listModel();
+    ObjectListModel::Samples samples;
+    if (scope.second.isEmpty())
+        samples = model->samples();
+    else
+        samples.insert(scope.second, model->samples().value(scope.second));
+
+    // the history older than the samples in memory comes from the on-disk store
+    SegmentStore *store = model->store();
+    QStringList storedNames;
+    if (store)
+        storedNames = scope.second.isEmpty() ? store->names() : QStringList(scope.second);
+
+    WidgetQmfObject *widget = widgetFor(scope.first);
+    historyExport = new HistoryExport(this, fileName, format, scope.first, widget->getSampleProperties(), samples,
+                                      store, storedNames);
+    historyProgress = new QProgressDialog(tr("Exporting %1 history...").arg(scope.first), tr("Cancel"), 0, 100, this);
+    historyProgress->setMinimumDuration(500);
+    connect(historyExport, SIGNAL(progress(int)), historyProgress, SLOT(setValue(int)));
+    connect(historyExport, SIGNAL(finished()), this, SLOT(historyExported()));
+    connect(historyProgress, SIGNAL(canceled()), this, SLOT(cancelHistoryExport()));
+    historyExport->start(QThread::LowPriority);
+}
+
+// SLOT triggered when the user cancels the history export
+void XView::cancelHistoryExport()
+{
+    if (historyExport)
+        historyExport->cancel();
+}
+
+// SLOT triggered when the history export thread is done
+void XView::historyExported()
+{
+    if (historyExport->succeeded())
+        statusBar()->showMessage(tr("Exported %1 samples to %2").arg(historyExport->rows()).arg(historyExport->fileName()), 5000);
+    else
+        statusBar()->showMessage(tr("History export to %1 did not complete").arg(historyExport->fileName()), 5000);
+
+    historyProgress->deleteLater();
+    historyProgress = 0;
+    historyExport->deleteLater();
+    historyExport = 0;
+}
+
+// SLOT triggered when an alert rule starts firing for an object
+void XView::alertRaised(const QString& qmfClass, const QString& name, const QString& rule, qreal value)
+{
+    label_alerts->setText(QString("<font color='red'>Alerts: %1</font>").arg(alertEngine->activeCount()));
+    statusBar()->showMessage(QString("%1 %2: %3").arg(qmfClass).arg(name).arg(rule), 5000);
+    writeAlert("raised", qmfClass, name, rule, value);
+}
+
+// SLOT triggered when an alert rule stops firing for an object
+void XView::alertCleared(const QString& qmfClass, const QString& name, const QString& rule, qreal value)
+{
+    int count = alertEngine->activeCount();
+    label_alerts->setText(count > 0 ? QString("<font color='red'>Alerts: %1</font>").arg(count) : QString());
+    writeAlert("cleared", qmfClass, name, rule, value);
+}
+
+// Write one tab separated line per alert event:
+//   time  raised|cleared  class  object  value  rule
+void XView::writeAlert(const QString& event, const QString& qmfClass, const QString& name, const QString& rule, qreal value)
+{
+    if (!alertFile)
+        return;
+
+    QString line = QString("%1\t%2\t%3\t%4\t%5\t%6\n")
+            .arg(QDateTime::currentDateTime().toString(Qt::ISODate))
+            .arg(event).arg(qmfClass).arg(name)
+            .arg(value, 0, 'g', 12).arg(rule);
+    alertFile->write(line.toUtf8());
+    alertFile->flush();
+}
+
+// SLOT triggered when the user edits the alert rules
+// Rules given on the command line are not saved
+void XView::saveRules()
+{
+    QStringList rules = alertEngine->rules();
+    QStringList::const_iterator iter = commandLineRules.constBegin();
+    while (iter != commandLineRules.constEnd()) {
+        rules.removeOne(*iter);
+        ++iter;
+    }
+    QSettings settings;
+    settings.setValue("alerts/rules", rules);
+}
+
+void XView::showMessage(const QString& message)
+{
+    statusBar()->showMessage(message, 5000);
 }
 
 // process command line arguments
+//   xview [options] [url [connection-options [session-options]]]
+// options:
+//   --headless       don't show the main window, just evaluate alert rules
+//   --rule=RULE      add an alert rule, e.g. --rule="queue: msgDepth > 1000 for 60s"
+//   --alerts=FILE    write alert lines to FILE, - for stdout (the default when headless)
 void XView::init(int argc, char *argv[])
 {
     QString url;
     QString connectionOptions;
     QString sessionOptions;
+    QString alertPath;
+    QString metricsPath;
+    int metricsPort = 0;
+
+    QStringList positional;
+    for (int i=1; i<argc; ++i) {
+        QString arg(argv[i]);
+        if (arg == "--headless")
+            headless = true;
+        else if (arg.startsWith("--rule=")) {
+            QString error;
+            QString rule = arg.mid(7);
+            if (alertEngine->addRule(rule, &error))
+                commandLineRules.append(rule);
+            else
+                std::cerr << "Bad alert rule '" << rule.toStdString() << "': " << error.toStdString() << std::endl;
+        }
+        else if (arg.startsWith("--alerts="))
+            alertPath = arg.mid(9);
+        else if (arg.startsWith("--metrics-file="))
+            metricsPath = arg.mid(15);
+        else if (arg.startsWith("--metrics-port="))
+            metricsPort = arg.mid(15).toInt();
+        else
+            positional.append(arg);
+    }
 
-    if (argc > 1) {
-        url = QString(argv[1]);
-        if (argc > 2) {
-            connectionOptions = QString(argv[2]);
-            if (argc > 3)
-                sessionOptions = QString(argv[3]);
+    if (positional.size() > 0) {
+        url = positional.at(0);
+        if (positional.size() > 1) {
+            connectionOptions = positional.at(1);
+            if (positional.size() > 2)
+                sessionOptions = positional.at(2);
         }
     }
-    // only connect if we have a url
+
+    if (alertPath.isEmpty() && headless)
+        alertPath = "-";
+    if (!alertPath.isEmpty()) {
+        alertFile = new QFile(this);
+        bool opened;
+        if (alertPath == "-")
+            opened = alertFile->open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+        else {
+            alertFile->setFileName(alertPath);
+            opened = alertFile->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+        }
+        if (!opened) {
+            std::cerr << "Unable to open " << alertPath.toStdString() << " for alerts" << std::endl;
+            delete alertFile;
+            alertFile = 0;
+        }
+    }
+
+    if (!metricsPath.isEmpty() || metricsPort > 0) {
+        metricsExporter = new MetricsExporter(this);
+        QList<ClassSection>::const_iterator iter = classSections.constBegin();
+        while (iter != classSections.constEnd()) {
+            metricsExporter->addModel((*iter).qmfClass, (*iter).dialog->listModel(), (*iter).widget->getSampleProperties());
+            ++iter;
+        }
+        if (!metricsPath.isEmpty())
+            metricsExporter->setFile(metricsPath);
+        if (metricsPort > 0 && !metricsExporter->listen(metricsPort))
+            std::cerr << "Unable to listen for metrics scrapes on port " << metricsPort << std::endl;
+        connect(qmf, SIGNAL(qmfTimer()), this, SLOT(queryMetrics()));
+    }
+
+    // only connect if we have a url. Headless mode has no menu to connect with
     if (!url.isEmpty())
         qmf->connect_url(url, connectionOptions, sessionOptions);
+    else if (headless)
+        qmf->connect_localhost();
 }
 
 XView::~XView()
 {
+    saveSnapshot();
+
     // save the window size and location
     QSettings settings;
     settings.setValue("mainWindowGeometry", saveGeometry());
     settings.setValue("mainWindowState", saveState());
     settings.setValue("mainWindowChecks/Charts", ui->actionCharts->isChecked());
     settings.setValue("mainWindowChecks/Layout", ui->action_Cascading->isChecked());
+    settings.setValue("mainWindowChecks/Animate", ui->actionAnimate_transitions->isChecked());
+    settings.setValue("mainWindowChecks/History", ui->actionKeep_history_on_disk->isChecked());
     settings.setValue("mainWindowChecks/Update", ui->actionUpdate_all->isChecked());
     settings.setValue("mainWindowChecks/Chart",   ui->actionDraw_area_charts->isChecked());
+    settings.setValue("mainWindowChecks/RateWindow", ui->actionRate_1_minute->isChecked() ? SampleRate::windowOneMinute :
+                      (ui->actionRate_5_minutes->isChecked() ? SampleRate::windowFiveMinutes : SampleRate::windowInstant));
 
     delete openDialog;
     delete aboutDialog;
@@ -606,11 +1436,39 @@ XView::~XView()
     delete subscriptionsDialog;
     delete sessionsDialog;
     delete connectionsDialog;
+    QList<Section>::const_iterator iSection = sections.constBegin();
+    while (iSection != sections.constEnd()) {
+        settings.setValue(QString("sections/%1/visible").arg((*iSection).widget->sectionName()),
+                          (*iSection).action->isChecked());
+        delete (*iSection).dialog;
+        ++iSection;
+    }
+    delete searchDialog;
+    delete searchIndex;
+    delete actionFind;
+    delete leaderboardDock;
+    delete leaderboard;
+    delete aggregator;
+    delete anomalyDetector;
+    delete backlogForecast;
+    delete alertsDock;
+    delete alertEngine;
+    delete label_alerts;
+    delete diagnosticsDock;
+    delete timelineBar;
+    delete metricsExporter;
+    qDeleteAll(historyStores);
+    if (historyExport) {
+        historyExport->cancel();
+        historyExport->wait();
+    }
+    delete label_diagnostics;
 
     delete label_connection_status;
     delete label_connection_prompt;
 
     delete chartGroup;
+    delete rateGroup;
     delete actionGroup;
     delete layoutGroup;
     delete updateGroup;
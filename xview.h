@@ -26,7 +26,23 @@
 #include "dialogabout.h"
 #include "dialogobjects.h"
 #include "dialogexchanges.h"
+#include "dialogsearch.h"
+#include "search-index.h"
+#include "leaderboard.h"
+#include "topology-aggregator.h"
+#include "anomaly-detector.h"
+#include "backlog-forecast.h"
+#include "dockleaderboard.h"
+#include "alert-engine.h"
+#include "dockalerts.h"
+#include "dockdiagnostics.h"
+#include "timelinebar.h"
+#include "metrics-exporter.h"
+#include "history-export.h"
+#include "segment-store.h"
+#include "topology-snapshot.h"
 #include "widgetqmfobject.h"
+#include "widgetsection.h"
 #include "fisheyelayout.h"
 
 namespace Ui {
@@ -45,6 +61,7 @@ public:
     ~XView();
 
     void init(int argc, char *argv[]);
+    bool isHeadless() const { return headless; }
 
 private:
     Ui::XView *ui;
@@ -57,20 +74,78 @@ private:
     DialogObjects*   subscriptionsDialog;
     DialogObjects*   sessionsDialog;
     DialogObjects*   connectionsDialog;
+
+    // every section, those in the ui and those added from data, with the
+    // class it shows. Everything that works per class is driven from this list
+    struct ClassSection {
+        QString qmfClass;
+        WidgetQmfObject *widget;
+        DialogObjects *dialog;
+    };
+    QList<ClassSection> classSections;
+    void registerSection(const QString& qmfClass, WidgetQmfObject *widget, DialogObjects *dialog);
+
+    // sections for the broker classes beyond the six in the ui
+    struct Section {
+        WidgetSection *widget;
+        DialogObjects *dialog;
+        QAction *action;    // shows and hides the section
+    };
+    QList<Section> sections;
+    void addSections(FisheyeLayout *layout, QSettings& settings);
+    void addSection(FisheyeLayout *layout, WidgetSection *widget, const std::string& key, QSettings& settings);
+
+    DialogSearch*    searchDialog;
+    SearchIndex*     searchIndex;
+    QAction*         actionFind;
+    Leaderboard*     leaderboard;
+    TopologyAggregator* aggregator;
+    AnomalyDetector* anomalyDetector;
+    BacklogForecast* backlogForecast;
+    DockLeaderboard* leaderboardDock;
+    AlertEngine*     alertEngine;
+    DockAlerts*      alertsDock;
+    DockDiagnostics* diagnosticsDock;
+    TimelineBar*     timelineBar;
+    MetricsExporter* metricsExporter;
+    HistoryExport*   historyExport;
+    QProgressDialog* historyProgress;
+    QList<SegmentStore*> historyStores;
+    TopologySnapshot snapshot;
+    QString brokerUrl;          // the broker we are connected to
+    bool snapshotLoaded;        // objects from the snapshot are waiting to be reconciled
     QActionGroup*    actionGroup;
     QActionGroup*    layoutGroup;
     QActionGroup*    updateGroup;
     QActionGroup*    chartGroup;
+    QActionGroup*    rateGroup;
     QToolBar*        modeToolBar;
 
     QmfThread* qmf;
     QLabel *label_connection_prompt;
     QLabel *label_connection_status;
+    QLabel *label_alerts;
+    QLabel *label_diagnostics;
+
+    // command line options
+    bool headless;
+    QStringList commandLineRules;
+    QFile *alertFile;
+    int alertClassIndex;
+    int metricsClassIndex;
+
+    // startup timings, see tracePhase()
+    qint64 startupStart;
+    qint64 phaseStart;
+    void tracePhase(const char *phase);
 
     void setupStatusBar();
     void queryObjects(const std::string& qmf_class, DialogObjects* dialog);
 
     void setMode(WidgetQmfObject::StatMode mode);
+    WidgetQmfObject *widgetFor(const QString& qmfClass);
+    DialogObjects *dialogFor(const QString& qmfClass);
+    void writeAlert(const QString& event, const QString& qmfClass, const QString& name, const QString& rule, qreal value);
 
 private slots:
     void queryExchanges();
@@ -85,9 +160,20 @@ private slots:
     void updateSubscription();
     void updateSession();
     void updateConnection();
+    void querySection();
+    void updateSection();
 
     void dispatchResponse(QObject *target, const qmf::ConsoleEvent& event, bool all);
     void queryCurrent();
+    void queryMetrics();
+    void exportHistory();
+    void toggleHistoryStore(bool keep);
+    void setViewTime(qint64 msecs);
+    void brokerConnected(const QString& url);
+    void reconcileSnapshot(bool connected);
+    void saveSnapshot();
+    void cancelHistoryExport();
+    void historyExported();
     void setMessageMode();
     void setByteMode();
     void setMessageRateMode();
@@ -95,6 +181,17 @@ private slots:
     void toggleLayout();
     void toggleUpdate();
     void toggleChartType();
+    void toggleRateWindow();
+    void searchSelected(const qmf::Data& object, const QString& qmfClass);
+    void queryAlerts();
+    void alertRaised(const QString& qmfClass, const QString& name, const QString& rule, qreal value);
+    void alertCleared(const QString& qmfClass, const QString& name, const QString& rule, qreal value);
+    void saveRules();
+    void showMessage(const QString& message);
+    void startupFinished();
+    void showOpenDialog();
+    void showAboutDialog();
+    void showSearchDialog();
 
 };
 
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui network
 
 TARGET = xview
 TEMPLATE = app
@@ -34,7 +34,31 @@ SOURCES += main.cpp\
     widgetconnections.cpp \
     fisheyelayout.cpp \
     propertydelegate.cpp \
-    relatedheaderview.cpp
+    relatedheaderview.cpp \
+    filter-model.cpp \
+    search-index.cpp \
+    dialogsearch.cpp \
+    leaderboard.cpp \
+    dockleaderboard.cpp \
+    expression.cpp \
+    alert-engine.cpp \
+    dockalerts.cpp \
+    rate-engine.cpp \
+    summary-model.cpp \
+    fisheyeoverlay.cpp \
+    histogram.cpp \
+    diagnostics.cpp \
+    dockdiagnostics.cpp \
+    metrics-exporter.cpp \
+    history-export.cpp \
+    segment-store.cpp \
+    topology-snapshot.cpp \
+    timelinebar.cpp \
+    sparklinedelegate.cpp \
+    topology-aggregator.cpp \
+    anomaly-detector.cpp \
+    backlog-forecast.cpp \
+    widgetsection.cpp
 
 HEADERS  += xview.h \
     qmf-thread.h \
@@ -59,14 +83,39 @@ HEADERS  += xview.h \
     widgetconnections.h \
     fisheyelayout.h \
     propertydelegate.h \
-    relatedheaderview.h
+    relatedheaderview.h \
+    filter-model.h \
+    search-index.h \
+    dialogsearch.h \
+    leaderboard.h \
+    dockleaderboard.h \
+    expression.h \
+    alert-engine.h \
+    dockalerts.h \
+    rate-engine.h \
+    summary-model.h \
+    fisheyeoverlay.h \
+    histogram.h \
+    diagnostics.h \
+    dockdiagnostics.h \
+    metrics-exporter.h \
+    history-export.h \
+    segment-store.h \
+    topology-snapshot.h \
+    timelinebar.h \
+    sparklinedelegate.h \
+    topology-aggregator.h \
+    anomaly-detector.h \
+    backlog-forecast.h \
+    widgetsection.h
 
 FORMS    += xview.ui \
     dialogopen.ui \
     dialogabout.ui \
     dialogobjects.ui \
     widgetqmfobject.ui \
-    chart.ui
+    chart.ui \
+    dialogsearch.ui
 
 OTHER_FILES += \
     license.txt \